@@ -0,0 +1,97 @@
+#include "DocumentSession.h"
+
+#include "PDFParser.h"
+
+using namespace std;
+using namespace PDFHummus;
+
+static const string scEmpty = "";
+
+DocumentSession::DocumentSession():inputSource(scEmpty) {
+    sourceReader = NULL;
+    parser = NULL;
+    LatestError.code = eErrorNone;
+    LatestError.description = scEmpty;
+}
+
+DocumentSession::~DocumentSession() {
+    Close();
+}
+
+EStatusCode DocumentSession::Open(const std::string& inFilePath, bool inShouldMemoryMap) {
+    return Open(InputSource(inFilePath, inShouldMemoryMap));
+}
+
+EStatusCode DocumentSession::Open(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize) {
+    return Open(InputSource(inBuffer, inBufferSize));
+}
+
+EStatusCode DocumentSession::Open(IByteReaderWithPosition* inSourceStream) {
+    return Open(InputSource(inSourceStream));
+}
+
+EStatusCode DocumentSession::Open(const InputSource& inSource) {
+    EStatusCode status = eSuccess;
+
+    Close();
+
+    LatestError.code = eErrorNone;
+    LatestError.description = scEmpty;
+
+    inputSource = inSource;
+    sourceReader = new InputSourceReader();
+    parser = new PDFParser();
+
+    do {
+        status = sourceReader->Open(inputSource);
+        if (status != eSuccess) {
+            LatestError.code = eErrorFileNotReadable;
+            LatestError.description = string("Cannot read ") + inputSource.GetDescription();
+            break;
+        }
+
+        status = parser->StartPDFParsing(sourceReader->GetInputStream());
+        if(status != eSuccess)
+        {
+            LatestError.code = eErrorInternalPDFWriter;
+            LatestError.description = string("Failed to parse file");
+            break;
+        }
+    } while(false);
+
+    if(status != eSuccess)
+        Close();
+
+    return status;
+}
+
+void DocumentSession::Close() {
+    // font decoders refer to objects of the parser, so they go first
+    textInterpeter.ResetInterpretationState();
+    textInterpeter.SetHandler(NULL);
+
+    delete parser;
+    parser = NULL;
+    delete sourceReader;
+    sourceReader = NULL;
+}
+
+bool DocumentSession::IsOpen() const {
+    return parser != NULL;
+}
+
+unsigned long DocumentSession::GetPagesCount() {
+    return parser ? parser->GetPagesCount() : 0;
+}
+
+PDFParser* DocumentSession::GetParser() {
+    return parser;
+}
+
+const InputSource& DocumentSession::GetInputSource() const {
+    return inputSource;
+}
+
+TextInterpeter& DocumentSession::GetTextInterpreter() {
+    return textInterpeter;
+}
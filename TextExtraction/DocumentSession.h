@@ -0,0 +1,56 @@
+#pragma once
+
+#include "EStatusCode.h"
+
+#include "./lib/text-parsing/TextInterpreter.h"
+#include "./lib/pdf-writer-enhancers/InputSource.h"
+
+#include "ErrorsAndWarnings.h"
+
+#include "IOBasicTypes.h"
+
+class PDFParser;
+class IByteReaderWithPosition;
+
+#include <string>
+
+/**
+ * DocumentSession parses a PDF once and keeps it open, so that TextExtraction and TableExtraction
+ * can run on any page range of it, any number of times, without re-reading the file and its xref.
+ * Font decoders built while interpreting are kept in the session as well, so fonts shared between pages
+ * are only parsed once per session, regardless of which extraction interpreted them.
+ * A session can only be used by one extraction at a time.
+ **/
+class DocumentSession {
+    public:
+        DocumentSession();
+        ~DocumentSession();
+
+        PDFHummus::EStatusCode Open(const std::string& inFilePath, bool inShouldMemoryMap = false);
+        // the buffer is read in place (not copied) and should stay valid for as long as the session is open
+        PDFHummus::EStatusCode Open(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize);
+        // the stream is not owned and should stay valid for as long as the session is open
+        PDFHummus::EStatusCode Open(IByteReaderWithPosition* inSourceStream);
+        PDFHummus::EStatusCode Open(const InputSource& inSource);
+        void Close();
+
+        bool IsOpen() const;
+        unsigned long GetPagesCount();
+
+        ExtractionError LatestError;
+
+        // for extractions using the session
+        PDFParser* GetParser();
+        const InputSource& GetInputSource() const;
+        TextInterpeter& GetTextInterpreter();
+
+    private:
+        InputSource inputSource;
+        InputSourceReader* sourceReader;
+        PDFParser* parser;
+        TextInterpeter textInterpeter;
+
+        // no copying. parser and reader are owned
+        DocumentSession(const DocumentSession&);
+        DocumentSession& operator=(const DocumentSession&);
+};
@@ -9,7 +9,9 @@ enum EExtractionWarning {
 enum EExtractionError {
     eErrorNone = 0, // null means no error
     eErrorFileNotReadable = 301,
-    eErrorInternalPDFWriter = 302
+    eErrorInternalPDFWriter = 302,
+    eErrorTimeout = 303, // time budget exceeded. results hold the pages completed till then
+    eErrorCancelled = 304 // cancelled from outside. results hold the pages completed till then
 };
 
 
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "./lib/text-parsing/ParsedTextPlacement.h"
+
+#include <string>
+
+/**
+ * Page handler for TextExtraction. When set, pages are reported to the handler, by page order, as soon as they
+ * are done, and then released (instead of being accumulated in textsForPages).
+ * When extracting with multiple jobs calls may come from worker threads, but they are never concurrent.
+ **/
+
+class ITextExtractionPageHandler {
+
+public:
+    // called for each page with the page text placements. return false to stop the extraction
+    virtual bool OnPageTextPlacementsComplete(unsigned long inPageIndex, const ParsedTextPlacementList& inTextPlacements) = 0;
+
+    // called right after OnPageTextPlacementsComplete with the page composed text, when the handler was set with composition options
+    virtual bool OnPageTextComplete(unsigned long inPageIndex, const std::string& inText) {return true;}
+};
@@ -1,6 +1,5 @@
 #include "TableExtraction.h"
 
-#include "InputFile.h"
 #include "PDFParser.h"
 #include "PDFWriter.h"
 #include "PDFPageInput.h"
@@ -10,6 +9,9 @@
 #include "./lib/graphic-content-parsing/GraphicContentInterpreter.h"
 #include "./lib/table-csv-export/TableCSVExport.h"
 #include "./lib/table-composition/TableComposer.h"
+#include "./lib/math/Transformations.h"
+#include "./lib/extraction-cache/PageContentHasher.h"
+#include "./lib/interpreter/ContentPrefetcher.h"
 
 #include <QTextCursor>
 
@@ -19,10 +21,34 @@ using namespace PDFHummus;
 
 
 TableExtraction::TableExtraction():
-    textInterpeter(this), 
     tableLineInterpreter(this)
 {
+    activeTextInterpeter = NULL;
+    useMemoryMapping = false;
+    prefetchPagesCount = 0;
+    currentPageRegions = NULL;
+    cancellationToken = NULL;
+    cache = NULL;
+}
+
+void TableExtraction::SetCancellationToken(const CancellationToken* inCancellationToken) {
+    cancellationToken = inCancellationToken;
+}
+
+void TableExtraction::SetCache(ExtractionCache* inCache) {
+    cache = inCache;
+}
+
+void TableExtraction::SetUseMemoryMapping(bool inUseMemoryMapping) {
+    useMemoryMapping = inUseMemoryMapping;
+}
+
+void TableExtraction::SetPrefetchPagesCount(unsigned long inPagesCount) {
+    prefetchPagesCount = inPagesCount;
+}
 
+void TableExtraction::SetRegionsOfInterest(const RegionsOfInterest& inRegionsOfInterest) {
+    regionsOfInterest = inRegionsOfInterest;
 }
     
 TableExtraction::~TableExtraction() {
@@ -44,12 +70,19 @@ bool TableExtraction::OnParsedVerticalLinePlacementComplete(const ParsedLinePlac
 
 
 bool TableExtraction::OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement) {
+    if(!!currentPageRegions && !DoesBoxIntersectRegions(inParsedTextPlacement.globalBbox, *currentPageRegions))
+        return true;
+
     textsForPages.back().push_back(inParsedTextPlacement);
     return true;
 }
 
 bool TableExtraction::OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters) {
-    return textInterpeter.OnTextElementComplete(inTextElement, inParameters);
+    return activeTextInterpeter->OnTextElementComplete(inTextElement, inParameters);
+}
+
+bool TableExtraction::OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters) {
+    return activeTextInterpeter->OnTextCommand(inCommand, inParameters);
 }
 
 bool TableExtraction::OnPathPainted(const PathElement& inPathElement) {
@@ -57,22 +90,45 @@ bool TableExtraction::OnPathPainted(const PathElement& inPathElement) {
 }
 
 bool TableExtraction::OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext) {
-    return textInterpeter.OnResourcesRead(inResources, inContext);
+    return activeTextInterpeter->OnResourcesRead(inResources, inContext);
+}
+
+unsigned int TableExtraction::GetInterests() {
+    // everything, with texts taken per command, so text elements are not buffered
+    return (eGraphicContentInterestAll & ~eGraphicContentInterestText) | eGraphicContentInterestTextCommands;
 }
 
-EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, long inStartPage, long inEndPage) {
+static const string scTablesResultsKind = "tables";
+
+EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, const InputSource& inSource, long inStartPage, long inEndPage) {
     EStatusCode status = eSuccess;
     unsigned long start = (unsigned long)(inStartPage >= 0 ? inStartPage : (inParser->GetPagesCount() + inStartPage));
     unsigned long end = (unsigned long)(inEndPage >= 0 ? inEndPage :  (inParser->GetPagesCount() + inEndPage));
     GraphicContentInterpreter interpreter;
-
+    interpreter.SetCancellationToken(cancellationToken);
+    PageContentHasher hasher(inParser);
 
     if(end > inParser->GetPagesCount()-1)
         end = inParser->GetPagesCount()-1;
     if(start > end)
         start = end;
 
+    // decode upcoming pages on other threads, while this one interprets
+    ContentPrefetcher* prefetcher = NULL;
+    if(prefetchPagesCount > 0 && start < end && inSource.CanOpenMultipleReaders()) {
+        prefetcher = new ContentPrefetcher(inSource, prefetchPagesCount);
+        interpreter.SetContentPrefetcher(prefetcher);
+    }
+
     for(unsigned long i=start;i<=end && status == eSuccess;++i) {
+        if(!!prefetcher)
+            prefetcher->OnPageStart(i, end);
+
+        if(!!cancellationToken && cancellationToken->ShouldStop()) {
+            status = eFailure;
+            break;
+        }
+
         RefCountPtr<PDFDictionary> pageObject(inParser->ParsePage(i));
         if(!pageObject) {
             status = eFailure;
@@ -80,16 +136,39 @@ EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, long in
         }
 
         PDFPageInput pageInput(inParser,pageObject);
+        currentPageRegions = regionsOfInterest.GetPageRegions(i);
+        interpreter.SetRegions(currentPageRegions);
 
         mediaBoxesForPages.push_back(pageInput.GetMediaBox());
         textsForPages.push_back(ParsedTextPlacementList());
         tableLinesForPages.push_back(Lines());
+
+        string cacheKey;
+        if(!!cache) {
+            PDFRectangle& mediaBox = mediaBoxesForPages.back();
+            double pageBox[4] = {mediaBox.LowerLeftX, mediaBox.LowerLeftY, mediaBox.UpperRightX, mediaBox.UpperRightY};
+            // results for regions are only a part of the page results, so keep them apart
+            string resultsKind = !currentPageRegions ? scTablesResultsKind : scTablesResultsKind + RegionsToString(*currentPageRegions);
+            cacheKey = hasher.ComputePageKey(pageObject.GetPtr(), pageBox, resultsKind);
+            if(cache->LoadTablePlacements(cacheKey, textsForPages.back(), tableLinesForPages.back()))
+                continue;
+        }
+
         // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements
-        interpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);
+        bool completed = interpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);
+        if(!completed && !!cancellationToken && cancellationToken->ShouldStop()) {
+            // stopped midway, so drop this page
+            mediaBoxesForPages.pop_back();
+            textsForPages.pop_back();
+            tableLinesForPages.pop_back();
+            status = eFailure;
+        }
+        else if(completed && !!cache) {
+            cache->StoreTablePlacements(cacheKey, textsForPages.back(), tableLinesForPages.back());
+        }
     }    
 
-    textInterpeter.ResetInterpretationState();
-
+    delete prefetcher;
     return status;
 }
 
@@ -97,9 +176,46 @@ static const string scEmpty = "";
 
 EStatusCode TableExtraction::ExtractTables(const std::string& inFilePath, long inStartPage,
                                            long inEndPage, bool inShouldComposeTables)
+{
+    return ExtractTables(InputSource(inFilePath, useMemoryMapping), inStartPage, inEndPage, inShouldComposeTables);
+}
+
+EStatusCode TableExtraction::ExtractTables(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize,
+                                           long inStartPage, long inEndPage, bool inShouldComposeTables)
+{
+    return ExtractTables(InputSource(inBuffer, inBufferSize), inStartPage, inEndPage, inShouldComposeTables);
+}
+
+EStatusCode TableExtraction::ExtractTables(IByteReaderWithPosition* inSourceStream, long inStartPage,
+                                           long inEndPage, bool inShouldComposeTables)
+{
+    return ExtractTables(InputSource(inSourceStream), inStartPage, inEndPage, inShouldComposeTables);
+}
+
+EStatusCode TableExtraction::ExtractTables(const InputSource& inSource, long inStartPage,
+                                           long inEndPage, bool inShouldComposeTables)
+{
+    DocumentSession session;
+
+    LatestWarnings.clear();
+    textsForPages.clear();
+    tableLinesForPages.clear();
+    tablesForPages.clear();
+    mediaBoxesForPages.clear();
+
+    EStatusCode status = session.Open(inSource);
+    if(status != eSuccess) {
+        LatestError = session.LatestError;
+        return status;
+    }
+
+    return ExtractTables(session, inStartPage, inEndPage, inShouldComposeTables);
+}
+
+EStatusCode TableExtraction::ExtractTables(DocumentSession& inSession, long inStartPage,
+                                           long inEndPage, bool inShouldComposeTables)
 {
     EStatusCode status = eSuccess;
-    InputFile sourceFile;
 
     LatestWarnings.clear();
     LatestError.code = eErrorNone;
@@ -111,24 +227,30 @@ EStatusCode TableExtraction::ExtractTables(const std::string& inFilePath, long i
     mediaBoxesForPages.clear();
 
     do {
-        status = sourceFile.OpenFile(inFilePath);
-        if (status != eSuccess) {
+        if(!inSession.IsOpen()) {
             LatestError.code = eErrorFileNotReadable;
-            LatestError.description = string("Cannot read file ") + inFilePath;
+            LatestError.description = string("Document session is not open");
+            status = eFailure;
             break;
         }
 
-
-        PDFParser parser;
-        status = parser.StartPDFParsing(sourceFile.GetInputStream());
-        if(status != eSuccess)
-        {
-            LatestError.code = eErrorInternalPDFWriter;
-            LatestError.description = string("Failed to parse file");
+        // interpret with the session text interpreter, so fonts decoders are reused between extractions
+        activeTextInterpeter = &inSession.GetTextInterpreter();
+        activeTextInterpeter->SetHandler(this);
+        status = ExtractTablePlacements(inSession.GetParser(), inSession.GetInputSource(), inStartPage, inEndPage);
+        // resources are read again by the next extraction, so its direct fonts won't match these decoders anyways
+        activeTextInterpeter->ReleaseEmbeddedFontDecoders();
+        activeTextInterpeter->SetHandler(NULL);
+        activeTextInterpeter = NULL;
+        if(status != eSuccess && !!cancellationToken && cancellationToken->ShouldStop()) {
+            // stopped from outside. still compose tables for the pages completed till then
+            LatestError.code = cancellationToken->IsCancelled() ? eErrorCancelled : eErrorTimeout;
+            LatestError.description = cancellationToken->IsCancelled() ? string("Extraction cancelled") : string("Extraction time budget exceeded");
+            if (inShouldComposeTables) {
+                ComposeTables();
+            }
             break;
         }
-
-        status = ExtractTablePlacements(&parser, inStartPage, inEndPage);
         if(status != eSuccess)
             break;
 
@@ -186,6 +308,29 @@ string TableExtraction::GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spa
     return exporter.GetText();
 }
 
+string TableExtraction::GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag) {
+    TextComposer composer(bidiFlag, spacingFlag);
+    ParsedTextPlacementListList::iterator itTextsforPages = textsForPages.begin();
+    PDFRectangleList::iterator itMediaBoxForPages = mediaBoxesForPages.begin();
+
+    for(; itTextsforPages != textsForPages.end() && itMediaBoxForPages != mediaBoxesForPages.end(); 
+            ++itTextsforPages, ++itMediaBoxForPages) {
+        // filter out elements outside of the page box, like text extraction does
+        double pageScopeBox[4] ={itMediaBoxForPages->LowerLeftX, itMediaBoxForPages->LowerLeftY, itMediaBoxForPages->UpperRightX, itMediaBoxForPages->UpperRightY};
+        ParsedTextPlacementList pageTexts;
+        ParsedTextPlacementList::iterator itTexts = itTextsforPages->begin();
+        for(; itTexts != itTextsforPages->end(); ++itTexts) {
+            if(DoBoxesIntersect(pageScopeBox, itTexts->globalBbox))
+                pageTexts.push_back(*itTexts);
+        }
+
+        composer.ComposeText(pageTexts);
+        composer.AppendText(scCRLN);
+    }
+
+    return composer.GetText();
+}
+
 void TableExtraction::GetResultsAsDocument(QTextDocument& inDocument)
 {
     QTextCursor cursor(&inDocument);
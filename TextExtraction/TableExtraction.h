@@ -7,15 +7,24 @@
 #include "./lib/text-parsing/ITextInterpreterHandler.h"
 #include "./lib/text-composition/TextComposer.h"
 #include "./lib/graphic-content-parsing/IGraphicContentInterpreterHandler.h"
+#include "./lib/graphic-content-parsing/RegionsOfInterest.h"
 #include "./lib/text-parsing/TextInterpreter.h"
 #include "./lib/table-line-parsing/TableLineInterpreter.h"
 #include "./lib/table-line-parsing/ITableLineInterpreterHandler.h"
 #include "./lib/table-composition/Lines.h"
 #include "./lib/table-composition/Table.h"
 
+#include "./lib/pdf-writer-enhancers/InputSource.h"
+#include "./lib/interpreter/CancellationToken.h"
+#include "./lib/extraction-cache/ExtractionCache.h"
+
 #include "ErrorsAndWarnings.h"
+#include "DocumentSession.h"
+
+#include "IOBasicTypes.h"
 
 class PDFParser;
+class IByteReaderWithPosition;
 class QTextDocument;
 
 #include <sstream>
@@ -36,6 +45,41 @@ class TableExtraction : public ITextInterpreterHandler, IGraphicContentInterpret
         PDFHummus::EStatusCode ExtractTables(const std::string& inFilePath, long inStartPage = 0,
                                              long inEndPage = -1,
                                              bool inShouldComposeTables = true);
+        // extract from a PDF in memory. the buffer is read in place (not copied) and should stay valid during extraction
+        PDFHummus::EStatusCode ExtractTables(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize,
+                                             long inStartPage = 0, long inEndPage = -1,
+                                             bool inShouldComposeTables = true);
+        PDFHummus::EStatusCode ExtractTables(IByteReaderWithPosition* inSourceStream, long inStartPage = 0,
+                                             long inEndPage = -1,
+                                             bool inShouldComposeTables = true);
+        PDFHummus::EStatusCode ExtractTables(const InputSource& inSource, long inStartPage = 0,
+                                             long inEndPage = -1,
+                                             bool inShouldComposeTables = true);
+        // extract from an already open document session. the session stays open, so it can go on to serve more extractions
+        PDFHummus::EStatusCode ExtractTables(DocumentSession& inSession, long inStartPage = 0,
+                                             long inEndPage = -1,
+                                             bool inShouldComposeTables = true);
+
+        // when extracting from a file path, read the file through memory mapping instead of buffered file reads.
+        // good for large files with lots of seeking around. default is false.
+        void SetUseMemoryMapping(bool inUseMemoryMapping);
+
+        // decode the content streams of upto inPagesCount pages ahead of the page being interpreted, on background threads,
+        // so decompression runs on other cores while this one interprets. only for extraction from a file or a buffer.
+        // default is 0 (no prefetching).
+        void SetPrefetchPagesCount(unsigned long inPagesCount);
+
+        // extract only the tables within regions of the pages. texts are selected by where they start, and table lines
+        // by intersecting the regions. pass empty regions to go back to extracting whole pages
+        void SetRegionsOfInterest(const RegionsOfInterest& inRegionsOfInterest);
+
+        // stop extraction once the token is cancelled or its deadline passes. tables are still composed for the pages
+        // completed till then, and LatestError is set to eErrorCancelled or eErrorTimeout. pass NULL to remove
+        void SetCancellationToken(const CancellationToken* inCancellationToken);
+
+        // keep page results (text placements and table lines) in a cache, and use cached results for pages with the
+        // same content instead of interpreting them again. the cache is not owned. pass NULL to remove
+        void SetCache(ExtractionCache* inCache);
 
         ExtractionError LatestError;
         ExtractionWarningList LatestWarnings;  
@@ -44,8 +88,10 @@ class TableExtraction : public ITextInterpreterHandler, IGraphicContentInterpret
 
         // IGraphicContentInterpreterHandler implementation
         virtual bool OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters = TextParameters());
+        virtual bool OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters = TextParameters());
         virtual bool OnPathPainted(const PathElement& inPathElement);
         virtual bool OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext);
+        virtual unsigned int GetInterests();
 
         // ITextInterpreterHandler implementation OnParsedTextPlacementCompleteWithFormat
         virtual bool OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement);
@@ -56,18 +102,29 @@ class TableExtraction : public ITextInterpreterHandler, IGraphicContentInterpret
 
         std::string GetTableAsCSVText(const Table& inTable, int bidiFlag, TextComposer::ESpacing spacingFlag);
         std::string GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spacingFlag);
+        // the text of the extracted pages, same as TextExtraction would have it. tables extraction collects
+        // all text placements anyways, so no need to interpret the pages again to get it
+        std::string GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag);
         void GetResultsAsDocument(QTextDocument& inDocument);
 
     private:
-        TextInterpeter textInterpeter;
         TableLineInterpreter tableLineInterpreter;
+        // text interpreter of the document session being extracted from
+        TextInterpeter* activeTextInterpeter;
 
         ParsedTextPlacementListList textsForPages;
         LinesList tableLinesForPages;
         PDFRectangleList mediaBoxesForPages;
+        bool useMemoryMapping;
+        unsigned long prefetchPagesCount;
+        RegionsOfInterest regionsOfInterest;
+        // regions of the page being extracted, NULL for the whole page
+        const RegionBoxList* currentPageRegions;
+        const CancellationToken* cancellationToken;
+        ExtractionCache* cache;
 
 
-        PDFHummus::EStatusCode ExtractTablePlacements(PDFParser* inParser, long inStartPage, long inEndPage);
+        PDFHummus::EStatusCode ExtractTablePlacements(PDFParser* inParser, const InputSource& inSource, long inStartPage, long inEndPage);
         void ComposeTables();
         
 };
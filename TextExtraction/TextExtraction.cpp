@@ -1,6 +1,5 @@
 #include "TextExtraction.h"
 
-#include "InputFile.h"
 #include "PDFParser.h"
 #include "PDFWriter.h"
 #include "PDFPageInput.h"
@@ -8,12 +7,106 @@
 #include "./lib/interpreter/PDFRecursiveInterpreter.h"
 #include "./lib/graphic-content-parsing/GraphicContentInterpreter.h"
 #include "./lib/math/Transformations.h"
+#include "./lib/extraction-cache/PageContentHasher.h"
+#include "./lib/interpreter/ContentPrefetcher.h"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <limits>
 
 using namespace std;
 using namespace PDFHummus;
 
+typedef std::vector<ParsedTextPlacementList> ParsedTextPlacementListVector;
+
+typedef std::vector<bool> BoolVector;
+
+// shared state for workers of a parallel extraction. workers pull page indexes from nextPage
+// and place each page result in its own slot, so page order is kept regardless of which worker got it.
+// when there's a page handler, pages are reported to it as soon as all pages before them are ready.
+struct ParallelPagesState {
+    TextExtraction* owner;
+    unsigned long startPage;
+    unsigned long endPage;
+    std::atomic<unsigned long> nextPage;
+
+    // the following are protected by lock
+    std::mutex lock;
+    unsigned long firstFailedPage;
+    bool stopped;
+    // set while a worker reports pages. reporting happens out of the lock, by one worker at a time
+    bool reporting;
+    unsigned long nextPageToReport;
+    ParsedTextPlacementListVector pagesResults;
+    BoolVector pagesReady;
+};
+
+static const string scCRLN = "\r\n";
+static const string scTextResultsKind = "text";
+
 TextExtraction::TextExtraction():textInterpeter(this) {
+    activeTextInterpeter = &textInterpeter;
+    jobsCount = 1;
+    prefetchPagesCount = 0;
+    useMemoryMapping = false;
+    currentPageRegions = NULL;
+    cancellationToken = NULL;
+    cache = NULL;
+    pageHandler = NULL;
+    composePageText = false;
+    pageBidiFlag = -1;
+    pageSpacingFlag = TextComposer::eSpacingBoth;
+}
+
+void TextExtraction::SetJobsCount(unsigned long inJobsCount) {
+    jobsCount = inJobsCount < 1 ? 1 : inJobsCount;
+}
+
+void TextExtraction::SetPrefetchPagesCount(unsigned long inPagesCount) {
+    prefetchPagesCount = inPagesCount;
+}
+
+void TextExtraction::SetUseMemoryMapping(bool inUseMemoryMapping) {
+    useMemoryMapping = inUseMemoryMapping;
+}
+
+void TextExtraction::SetRegionsOfInterest(const RegionsOfInterest& inRegionsOfInterest) {
+    regionsOfInterest = inRegionsOfInterest;
+}
 
+void TextExtraction::SetCancellationToken(const CancellationToken* inCancellationToken) {
+    cancellationToken = inCancellationToken;
+}
+
+void TextExtraction::SetCache(ExtractionCache* inCache) {
+    cache = inCache;
+}
+
+void TextExtraction::SetPageHandler(ITextExtractionPageHandler* inPageHandler) {
+    pageHandler = inPageHandler;
+    composePageText = false;
+}
+
+void TextExtraction::SetPageHandler(ITextExtractionPageHandler* inPageHandler, int bidiFlag, TextComposer::ESpacing spacingFlag) {
+    pageHandler = inPageHandler;
+    composePageText = true;
+    pageBidiFlag = bidiFlag;
+    pageSpacingFlag = spacingFlag;
+}
+
+bool TextExtraction::ReportPage(unsigned long inPageIndex, const ParsedTextPlacementList& inTextPlacements) {
+    if(!pageHandler->OnPageTextPlacementsComplete(inPageIndex, inTextPlacements))
+        return false;
+
+    if(!composePageText)
+        return true;
+
+    TextComposer composer(pageBidiFlag, pageSpacingFlag);
+    composer.ComposeText(inTextPlacements);
+    composer.AppendText(scCRLN);
+    return pageHandler->OnPageTextComplete(inPageIndex, composer.GetText());
 }
     
 TextExtraction::~TextExtraction() {
@@ -21,15 +114,20 @@ TextExtraction::~TextExtraction() {
 }
 
 bool TextExtraction::OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement) {
-    // filter out elements outside of the page box
-    if(DoBoxesIntersect(currentPageScopeBox, inParsedTextPlacement.globalBbox))
+    // filter out elements outside of the page box (and the page regions, when limited to regions)
+    if(DoBoxesIntersect(currentPageScopeBox, inParsedTextPlacement.globalBbox) &&
+        (!currentPageRegions || DoesBoxIntersectRegions(inParsedTextPlacement.globalBbox, *currentPageRegions)))
         textsForPages.back().push_back(inParsedTextPlacement);
     return true;
 }
 
 
 bool TextExtraction::OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters) {
-    return textInterpeter.OnTextElementComplete(inTextElement, inParameters);
+    return activeTextInterpeter->OnTextElementComplete(inTextElement, inParameters);
+}
+
+bool TextExtraction::OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters) {
+    return activeTextInterpeter->OnTextCommand(inCommand, inParameters);
 }
 
 bool TextExtraction::OnPathPainted(const PathElement& inPathElement) {
@@ -37,52 +135,267 @@ bool TextExtraction::OnPathPainted(const PathElement& inPathElement) {
     return true;
 }
 
+unsigned int TextExtraction::GetInterests() {
+    // paths are not relevant for text extraction, so don't have them built at all. texts are taken per command,
+    // so text elements are not buffered
+    return eGraphicContentInterestTextCommands | eGraphicContentInterestResources;
+}
+
 
 bool TextExtraction::OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext) {
-    return textInterpeter.OnResourcesRead(inResources, inContext);
+    return activeTextInterpeter->OnResourcesRead(inResources, inContext);
 }
 
-EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, long inStartPage, long inEndPage) {
+static void ComputePagesRange(PDFParser* inParser, long inStartPage, long inEndPage, unsigned long& outStart, unsigned long& outEnd) {
+    outStart = (unsigned long)(inStartPage >= 0 ? inStartPage : (inParser->GetPagesCount() + inStartPage));
+    outEnd = (unsigned long)(inEndPage >= 0 ? inEndPage :  (inParser->GetPagesCount() + inEndPage));
+
+    if(outEnd > inParser->GetPagesCount()-1)
+        outEnd = inParser->GetPagesCount()-1;
+    if(outStart > outEnd)
+        outStart = outEnd;
+}
+
+EStatusCode TextExtraction::ExtractPageTextPlacements(PDFParser* inParser, GraphicContentInterpreter& inInterpreter, PageContentHasher* inHasher, unsigned long inPageIndex) {
+    if(!!cancellationToken && cancellationToken->ShouldStop())
+        return eFailure;
+
+    RefCountPtr<PDFDictionary> pageObject(inParser->ParsePage(inPageIndex));
+    if(!pageObject)
+        return eFailure;
+
+    PDFPageInput pageInput(inParser,pageObject);
+    PDFRectangle mediaBox = pageInput.GetMediaBox();
+    currentPageScopeBox[0] = mediaBox.LowerLeftX;
+    currentPageScopeBox[1] = mediaBox.LowerLeftY;
+    currentPageScopeBox[2] = mediaBox.UpperRightX;
+    currentPageScopeBox[3] = mediaBox.UpperRightY;
+    currentPageRegions = regionsOfInterest.GetPageRegions(inPageIndex);
+    inInterpreter.SetRegions(currentPageRegions);
+
+    textsForPages.push_back(ParsedTextPlacementList());
+
+    string cacheKey;
+    if(!!inHasher) {
+        // results for regions are only a part of the page results, so keep them apart
+        string resultsKind = !currentPageRegions ? scTextResultsKind : scTextResultsKind + RegionsToString(*currentPageRegions);
+        cacheKey = inHasher->ComputePageKey(pageObject.GetPtr(), currentPageScopeBox, resultsKind);
+        if(cache->LoadTextPlacements(cacheKey, textsForPages.back()))
+            return eSuccess;
+    }
+
+    // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements
+    bool completed = inInterpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);  
+    if(!completed && !!cancellationToken && cancellationToken->ShouldStop()) {
+        // stopped midway, so drop this page
+        textsForPages.pop_back();
+        return eFailure;
+    }
+
+    if(completed && !!inHasher)
+        cache->StoreTextPlacements(cacheKey, textsForPages.back());
+
+    return eSuccess;
+}
+
+EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, const InputSource& inSource, long inStartPage, long inEndPage) {
     EStatusCode status = eSuccess;
-    unsigned long start = (unsigned long)(inStartPage >= 0 ? inStartPage : (inParser->GetPagesCount() + inStartPage));
-    unsigned long end = (unsigned long)(inEndPage >= 0 ? inEndPage :  (inParser->GetPagesCount() + inEndPage));
+    unsigned long start,end;
     GraphicContentInterpreter interpreter;
+    interpreter.SetCancellationToken(cancellationToken);
+    PageContentHasher hasher(inParser);
 
+    ComputePagesRange(inParser, inStartPage, inEndPage, start, end);
 
-    if(end > inParser->GetPagesCount()-1)
-        end = inParser->GetPagesCount()-1;
-    if(start > end)
-        start = end;
+    // decode upcoming pages on other threads, while this one interprets
+    ContentPrefetcher* prefetcher = NULL;
+    if(prefetchPagesCount > 0 && start < end && inSource.CanOpenMultipleReaders()) {
+        prefetcher = new ContentPrefetcher(inSource, prefetchPagesCount);
+        interpreter.SetContentPrefetcher(prefetcher);
+    }
 
     for(unsigned long i=start;i<=end && status == eSuccess;++i) {
-        RefCountPtr<PDFDictionary> pageObject(inParser->ParsePage(i));
-        if(!pageObject) {
-            status = eFailure;
+        if(!!prefetcher)
+            prefetcher->OnPageStart(i, end);
+
+        status = ExtractPageTextPlacements(inParser, interpreter, !!cache ? &hasher : NULL, i);
+        if(status != eSuccess || !pageHandler)
+            continue;
+
+        // report and release the page
+        bool shouldContinue = ReportPage(i, textsForPages.back());
+        textsForPages.pop_back();
+        if(!shouldContinue)
+            break;
+    }    
+
+    delete prefetcher;
+    return status;
+}
+
+void TextExtraction::ExtractPagesForWorker(PDFParser* inParser, ParallelPagesState* inState) {
+    GraphicContentInterpreter interpreter;
+    interpreter.SetCancellationToken(cancellationToken);
+    PageContentHasher hasher(inParser);
+
+    while(true) {
+        unsigned long pageIndex = inState->nextPage++;
+        if(pageIndex > inState->endPage)
             break;
+
+        {
+            // no point in going on with pages past a failed page, they'll be dropped anyways
+            lock_guard<mutex> lock(inState->lock);
+            if(pageIndex > inState->firstFailedPage || inState->stopped)
+                break;
         }
 
-        PDFPageInput pageInput(inParser,pageObject);
-        PDFRectangle mediaBox = pageInput.GetMediaBox();
-        currentPageScopeBox[0] = mediaBox.LowerLeftX;
-        currentPageScopeBox[1] = mediaBox.LowerLeftY;
-        currentPageScopeBox[2] = mediaBox.UpperRightX;
-        currentPageScopeBox[3] = mediaBox.UpperRightY;
+        if(ExtractPageTextPlacements(inParser, interpreter, !!cache ? &hasher : NULL, pageIndex) != eSuccess) {
+            lock_guard<mutex> lock(inState->lock);
+            if(pageIndex < inState->firstFailedPage)
+                inState->firstFailedPage = pageIndex;
+            break;
+        }
 
-        textsForPages.push_back(ParsedTextPlacementList());
-        // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements
-        interpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);  
-    }    
+        bool shouldContinue = inState->owner->OnParallelPageComplete(inState, pageIndex, textsForPages.back());
+        textsForPages.clear();
+        if(!shouldContinue)
+            break;
+    }
 
     textInterpeter.ResetInterpretationState();
+}
 
-    return status;
+bool TextExtraction::OnParallelPageComplete(ParallelPagesState* inState, unsigned long inPageIndex, ParsedTextPlacementList& ioTextPlacements) {
+    unique_lock<mutex> lock(inState->lock);
+
+    inState->pagesResults[inPageIndex - inState->startPage].swap(ioTextPlacements);
+    inState->pagesReady[inPageIndex - inState->startPage] = true;
+
+    if(!pageHandler)
+        return true;
+
+    // a worker is already reporting. it checks for ready pages again after each page, so it'll get to this one
+    if(inState->reporting)
+        return !inState->stopped;
+
+    // report all pages that are ready by order. pages after a failed page are never ready, so reporting naturally stops there.
+    // pages are taken out under the lock, and composed and reported out of it, so that other workers don't wait on the handler
+    inState->reporting = true;
+    while(!inState->stopped && 
+            inState->nextPageToReport <= inState->endPage && 
+            inState->pagesReady[inState->nextPageToReport - inState->startPage]) {
+        unsigned long pageIndex = inState->nextPageToReport;
+        ParsedTextPlacementList page;
+        page.swap(inState->pagesResults[pageIndex - inState->startPage]);
+        ++inState->nextPageToReport;
+
+        lock.unlock();
+        bool shouldContinue = ReportPage(pageIndex, page);
+        lock.lock();
+
+        if(!shouldContinue)
+            inState->stopped = true;
+    }
+    inState->reporting = false;
+
+    return !inState->stopped;
+}
+
+void TextExtraction::RunExtractionWorker(const InputSource* inSource, ParallelPagesState* inState) {
+    // each worker gets its own reader and parser, so that reading positions are not shared between workers
+    InputSourceReader sourceReader;
+    if(sourceReader.Open(*inSource) != eSuccess)
+        return;
+
+    PDFParser parser;
+    if(parser.StartPDFParsing(sourceReader.GetInputStream()) != eSuccess)
+        return;
+
+    TextExtraction worker;
+    worker.cancellationToken = inState->owner->cancellationToken;
+    worker.cache = inState->owner->cache;
+    worker.regionsOfInterest = inState->owner->regionsOfInterest;
+    worker.ExtractPagesForWorker(&parser, inState);
+}
+
+EStatusCode TextExtraction::ExtractTextPlacementsInParallel(PDFParser* inParser, const InputSource& inSource, unsigned long inStartPage, unsigned long inEndPage) {
+    ParallelPagesState state;
+    unsigned long pagesCount = inEndPage - inStartPage + 1;
+    unsigned long workersCount = jobsCount < pagesCount ? jobsCount : pagesCount;
+
+    state.owner = this;
+    state.startPage = inStartPage;
+    state.endPage = inEndPage;
+    state.nextPage = inStartPage;
+    state.firstFailedPage = numeric_limits<unsigned long>::max();
+    state.stopped = false;
+    state.reporting = false;
+    state.nextPageToReport = inStartPage;
+    state.pagesResults.resize(pagesCount);
+    state.pagesReady.resize(pagesCount, false);
+
+    // additional workers run on their own threads, while this thread also acts as a worker using the
+    // already started parser. this way there's always at least one worker making progress, even if
+    // the others fail to open the file.
+    vector<thread> workers;
+    for(unsigned long i=1; i < workersCount; ++i)
+        workers.push_back(thread(&TextExtraction::RunExtractionWorker, &inSource, &state));
+
+    // the main worker uses the parser of this thread, so it can also use its font decoders
+    TextExtraction mainWorker;
+    mainWorker.cancellationToken = cancellationToken;
+    mainWorker.cache = cache;
+    mainWorker.regionsOfInterest = regionsOfInterest;
+    mainWorker.activeTextInterpeter = activeTextInterpeter;
+    activeTextInterpeter->SetHandler(&mainWorker);
+    mainWorker.ExtractPagesForWorker(inParser, &state);
+    activeTextInterpeter->SetHandler(this);
+
+    for(vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+        it->join();
+
+    // collect results by page order, upto the first failed page (same as the sequential extraction would).
+    // with a page handler they were already reported.
+    for(unsigned long i=0; i < pagesCount && inStartPage + i < state.firstFailedPage && !pageHandler; ++i) {
+        textsForPages.push_back(ParsedTextPlacementList());
+        textsForPages.back().swap(state.pagesResults[i]);
+    }
+
+    return state.firstFailedPage <= inEndPage ? eFailure : eSuccess;
 }
 
 static const string scEmpty = "";
 
 EStatusCode TextExtraction::ExtractText(const std::string& inFilePath, long inStartPage, long inEndPage) {
+    return ExtractText(InputSource(inFilePath, useMemoryMapping), inStartPage, inEndPage);
+}
+
+EStatusCode TextExtraction::ExtractText(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize, long inStartPage, long inEndPage) {
+    return ExtractText(InputSource(inBuffer, inBufferSize), inStartPage, inEndPage);
+}
+
+EStatusCode TextExtraction::ExtractText(IByteReaderWithPosition* inSourceStream, long inStartPage, long inEndPage) {
+    return ExtractText(InputSource(inSourceStream), inStartPage, inEndPage);
+}
+
+EStatusCode TextExtraction::ExtractText(const InputSource& inSource, long inStartPage, long inEndPage) {
+    DocumentSession session;
+
+    LatestWarnings.clear();
+    textsForPages.clear();
+
+    EStatusCode status = session.Open(inSource);
+    if(status != eSuccess) {
+        LatestError = session.LatestError;
+        return status;
+    }
+
+    return ExtractText(session, inStartPage, inEndPage);
+}
+
+EStatusCode TextExtraction::ExtractText(DocumentSession& inSession, long inStartPage, long inEndPage) {
     EStatusCode status = eSuccess;
-    InputFile sourceFile;
 
     LatestWarnings.clear();
     LatestError.code = eErrorNone;
@@ -90,35 +403,38 @@ EStatusCode TextExtraction::ExtractText(const std::string& inFilePath, long inSt
 
     textsForPages.clear();
 
-    do {
-        status = sourceFile.OpenFile(inFilePath);
-        if (status != eSuccess) {
-            LatestError.code = eErrorFileNotReadable;
-            LatestError.description = string("Cannot read file ") + inFilePath;
-            break;
-        }
-
+    if(!inSession.IsOpen()) {
+        LatestError.code = eErrorFileNotReadable;
+        LatestError.description = string("Document session is not open");
+        return eFailure;
+    }
 
-        PDFParser parser;
-        status = parser.StartPDFParsing(sourceFile.GetInputStream());
-        if(status != eSuccess)
-        {
-            LatestError.code = eErrorInternalPDFWriter;
-            LatestError.description = string("Failed to parse file");
-            break;
-        }
+    // interpret with the session text interpreter, so fonts decoders are reused between extractions
+    activeTextInterpeter = &inSession.GetTextInterpreter();
+    activeTextInterpeter->SetHandler(this);
+
+    PDFParser* parser = inSession.GetParser();
+    if(jobsCount > 1 && inSession.GetInputSource().CanOpenMultipleReaders()) {
+        unsigned long start,end;
+        ComputePagesRange(parser, inStartPage, inEndPage, start, end);
+        status = ExtractTextPlacementsInParallel(parser, inSession.GetInputSource(), start, end);
+    } else {
+        status = ExtractTextPlacements(parser, inSession.GetInputSource(), inStartPage, inEndPage);
+    }
 
-        status = ExtractTextPlacements(&parser, inStartPage, inEndPage);
-        if(status != eSuccess)
-            break;
+    // resources are read again by the next extraction, so its direct fonts won't match these decoders anyways
+    activeTextInterpeter->ReleaseEmbeddedFontDecoders();
+    activeTextInterpeter->SetHandler(NULL);
+    activeTextInterpeter = &textInterpeter;
 
-    } while(false);
+    if(status != eSuccess && !!cancellationToken && cancellationToken->ShouldStop()) {
+        LatestError.code = cancellationToken->IsCancelled() ? eErrorCancelled : eErrorTimeout;
+        LatestError.description = cancellationToken->IsCancelled() ? string("Extraction cancelled") : string("Extraction time budget exceeded");
+    }
 
     return status;
 }
 
-static const string scCRLN = "\r\n";
-
 std::string TextExtraction::GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag) {
     ParsedTextPlacementListList::iterator itPages = textsForPages.begin();
     TextComposer composer(bidiFlag, spacingFlag);
@@ -6,11 +6,24 @@
 #include "./lib/text-parsing/ITextInterpreterHandler.h"
 #include "./lib/text-composition/TextComposer.h"
 #include "./lib/graphic-content-parsing/IGraphicContentInterpreterHandler.h"
+#include "./lib/graphic-content-parsing/RegionsOfInterest.h"
 #include "./lib/text-parsing/TextInterpreter.h"
 
+#include "./lib/pdf-writer-enhancers/InputSource.h"
+#include "./lib/interpreter/CancellationToken.h"
+#include "./lib/extraction-cache/ExtractionCache.h"
+
 #include "ErrorsAndWarnings.h"
+#include "ITextExtractionPageHandler.h"
+#include "DocumentSession.h"
+
+#include "IOBasicTypes.h"
 
 class PDFParser;
+class IByteReaderWithPosition;
+class GraphicContentInterpreter;
+class PageContentHasher;
+struct ParallelPagesState;
 
 #include <sstream>
 #include <string>
@@ -27,6 +40,43 @@ class TextExtraction : public ITextInterpreterHandler, IGraphicContentInterprete
         virtual ~TextExtraction();
 
         PDFHummus::EStatusCode ExtractText(const std::string& inFilePath, long inStartPage=0, long inEndPage=-1);
+        // extract from a PDF in memory. the buffer is read in place (not copied) and should stay valid during extraction
+        PDFHummus::EStatusCode ExtractText(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize, long inStartPage=0, long inEndPage=-1);
+        // extract from a caller provided stream. as the stream can't be shared between workers, extraction from it is sequential
+        PDFHummus::EStatusCode ExtractText(IByteReaderWithPosition* inSourceStream, long inStartPage=0, long inEndPage=-1);
+        PDFHummus::EStatusCode ExtractText(const InputSource& inSource, long inStartPage=0, long inEndPage=-1);
+        // extract from an already open document session. the session stays open, so it can go on to serve more extractions
+        PDFHummus::EStatusCode ExtractText(DocumentSession& inSession, long inStartPage=0, long inEndPage=-1);
+
+        // number of workers to use for extraction. each worker parses the file on its own and interprets
+        // a share of the pages, results are still placed in textsForPages by page order. default is 1 (no parallelism).
+        void SetJobsCount(unsigned long inJobsCount);
+
+        // decode the content streams of upto inPagesCount pages ahead of the page being interpreted, on background threads,
+        // so decompression runs on other cores while this one interprets. only for sequential extraction (a single job)
+        // from a file or a buffer. default is 0 (no prefetching).
+        void SetPrefetchPagesCount(unsigned long inPagesCount);
+
+        // when extracting from a file path, read the file through memory mapping instead of buffered file reads.
+        // good for large files with lots of seeking around. default is false.
+        void SetUseMemoryMapping(bool inUseMemoryMapping);
+
+        // extract only the texts within regions of the pages. texts are selected by where they start, so that
+        // pages content outside of the regions is skipped early on. pass empty regions to go back to extracting whole pages
+        void SetRegionsOfInterest(const RegionsOfInterest& inRegionsOfInterest);
+
+        // stop extraction once the token is cancelled or its deadline passes. the pages completed till then are
+        // kept (or reported) as usual, and LatestError is set to eErrorCancelled or eErrorTimeout. pass NULL to remove
+        void SetCancellationToken(const CancellationToken* inCancellationToken);
+
+        // keep page results in a cache, and use cached results for pages with the same content instead of
+        // interpreting them again. the cache is not owned, and may be shared between extractions. pass NULL to remove
+        void SetCache(ExtractionCache* inCache);
+
+        // report pages to a handler as they are done, instead of accumulating them in textsForPages.
+        // use the second form to also get each page composed text. pass NULL to go back to accumulating.
+        void SetPageHandler(ITextExtractionPageHandler* inPageHandler);
+        void SetPageHandler(ITextExtractionPageHandler* inPageHandler, int bidiFlag, TextComposer::ESpacing spacingFlag);
 
         ExtractionError LatestError;
         ExtractionWarningList LatestWarnings;  
@@ -44,15 +94,37 @@ class TextExtraction : public ITextInterpreterHandler, IGraphicContentInterprete
 
         // IGraphicContentInterpreterHandler implementation
         virtual bool OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters = TextParameters());
+        virtual bool OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters = TextParameters());
         virtual bool OnPathPainted(const PathElement& inPathElement);
         virtual bool OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext);
+        virtual unsigned int GetInterests();
 
         // ITextInterpreterHandler implementation
         virtual bool OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement); 
 
     private:
         TextInterpeter textInterpeter;
+        // the text interpreter in use. either the own one or that of a document session
+        TextInterpeter* activeTextInterpeter;
         double currentPageScopeBox[4];
-
-        PDFHummus::EStatusCode ExtractTextPlacements(PDFParser* inParser, long inStartPage, long inEndPage);
+        RegionsOfInterest regionsOfInterest;
+        // regions of the page being extracted, NULL for the whole page
+        const RegionBoxList* currentPageRegions;
+        unsigned long jobsCount;
+        unsigned long prefetchPagesCount;
+        bool useMemoryMapping;
+        const CancellationToken* cancellationToken;
+        ExtractionCache* cache;
+        ITextExtractionPageHandler* pageHandler;
+        bool composePageText;
+        int pageBidiFlag;
+        TextComposer::ESpacing pageSpacingFlag;
+
+        PDFHummus::EStatusCode ExtractTextPlacements(PDFParser* inParser, const InputSource& inSource, long inStartPage, long inEndPage);
+        PDFHummus::EStatusCode ExtractTextPlacementsInParallel(PDFParser* inParser, const InputSource& inSource, unsigned long inStartPage, unsigned long inEndPage);
+        PDFHummus::EStatusCode ExtractPageTextPlacements(PDFParser* inParser, GraphicContentInterpreter& inInterpreter, PageContentHasher* inHasher, unsigned long inPageIndex);
+        void ExtractPagesForWorker(PDFParser* inParser, ParallelPagesState* inState);
+        bool OnParallelPageComplete(ParallelPagesState* inState, unsigned long inPageIndex, ParsedTextPlacementList& ioTextPlacements);
+        bool ReportPage(unsigned long inPageIndex, const ParsedTextPlacementList& inTextPlacements);
+        static void RunExtractionWorker(const InputSource* inSource, ParallelPagesState* inState);
 };
@@ -23,27 +23,40 @@ INCLUDEPATH += $$PWD
 
 HEADERS += \
     lib/bidi/BidiConversion.h \
+    lib/extraction-cache/ContentHash.h \
+    lib/extraction-cache/ExtractionCache.h \
+    lib/extraction-cache/PageContentHasher.h \
     lib/font-translation/Encoding.h \
     lib/font-translation/FontDecoder.h \
     lib/font-translation/StandardFontsDimensions.h \
     lib/font-translation/Translation.h \
     lib/graphic-content-parsing/ContentGraphicState.h \
+    lib/graphic-content-parsing/FormResult.h \
     lib/graphic-content-parsing/GraphicContentInterpreter.h \
     lib/graphic-content-parsing/IGraphicContentInterpreterHandler.h \
     lib/graphic-content-parsing/Path.h \
     lib/graphic-content-parsing/PathElement.h \
+    lib/graphic-content-parsing/RegionsOfInterest.h \
     lib/graphic-content-parsing/Resources.h \
     lib/graphic-content-parsing/TextElement.h \
     lib/graphic-content-parsing/TextGraphicState.h \
     lib/graphs/Graph.h \
     lib/graphs/Queue.h \
     lib/graphs/Result.h \
+    lib/interpreter/CancellationToken.h \
+    lib/interpreter/ContentOperandStack.h \
+    lib/interpreter/ContentOperators.h \
+    lib/interpreter/ContentPrefetcher.h \
+    lib/interpreter/ContentStreamLexer.h \
     lib/interpreter/IPDFInterpreterHandler.h \
     lib/interpreter/IPDFRecursiveInterpreterHandler.h \
+    lib/interpreter/InterpreterContext.h \
     lib/interpreter/PDFInterpreter.h \
     lib/interpreter/PDFRecursiveInterpreter.h \
     lib/math/Transformations.h \
     lib/pdf-writer-enhancers/Bytes.h \
+    lib/pdf-writer-enhancers/InputMemoryMappedFile.h \
+    lib/pdf-writer-enhancers/InputSource.h \
     lib/table-csv-export/TableCSVExport.h \
     lib/table-line-parsing/ITableLineInterpreterHandler.h \
     lib/table-line-parsing/ParsedLinePlacement.h \
@@ -55,25 +68,40 @@ HEADERS += \
     lib/text-parsing/ITextInterpreterHandler.h \
     lib/text-parsing/ParsedTextPlacement.h \
     lib/text-parsing/TextInterpreter.h \
+    DocumentSession.h \
     ErrorsAndWarnings.h \
+    ITextExtractionPageHandler.h \
     TableExtraction.h \
     TextExtraction.h
 
 SOURCES += \
     lib/bidi/BidiConversion.cpp \
+    lib/extraction-cache/ContentHash.cpp \
+    lib/extraction-cache/ExtractionCache.cpp \
+    lib/extraction-cache/PageContentHasher.cpp \
     lib/font-translation/Encoding.cpp \
     lib/font-translation/FontDecoder.cpp \
     lib/font-translation/StandardFontsDimensions.cpp \
     lib/graphic-content-parsing/GraphicContentInterpreter.cpp \
+    lib/graphic-content-parsing/RegionsOfInterest.cpp \
+    lib/interpreter/CancellationToken.cpp \
+    lib/interpreter/ContentOperandStack.cpp \
+    lib/interpreter/ContentOperators.cpp \
+    lib/interpreter/ContentPrefetcher.cpp \
+    lib/interpreter/ContentStreamLexer.cpp \
+    lib/interpreter/InterpreterContext.cpp \
     lib/interpreter/PDFInterpreter.cpp \
     lib/interpreter/PDFRecursiveInterpreter.cpp \
     lib/math/Transformations.cpp \
     lib/pdf-writer-enhancers/Bytes.cpp \
+    lib/pdf-writer-enhancers/InputMemoryMappedFile.cpp \
+    lib/pdf-writer-enhancers/InputSource.cpp \
     lib/table-csv-export/TableCSVExport.cpp \
     lib/table-line-parsing/TableLineInterpreter.cpp \
     lib/table-composition/Table.cpp \
     lib/table-composition/TableComposer.cpp \
     lib/text-composition/TextComposer.cpp \
     lib/text-parsing/TextInterpreter.cpp \
+    DocumentSession.cpp \
     TableExtraction.cpp \
     TextExtraction.cpp 
@@ -0,0 +1,60 @@
+#include "ContentHash.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace IOBasicTypes;
+
+// FNV-1a 128 bit offset basis is 0x6c62272e07bb014262b821756295c58d, and its prime is 2^88 + 0x13B
+static const uint64_t scOffsetBasisHigh = 0x6c62272e07bb0142ULL;
+static const uint64_t scOffsetBasisLow = 0x62b821756295c58dULL;
+static const uint64_t scPrimeLowPart = 0x13B;
+
+ContentHash::ContentHash() {
+    high = scOffsetBasisHigh;
+    low = scOffsetBasisLow;
+}
+
+void ContentHash::Accumulate(const Byte* inBytes, size_t inLength) {
+    for(size_t i = 0; i < inLength; ++i) {
+        low ^= inBytes[i];
+
+        // multiply by the prime, mod 2^128. that's hash * 0x13B + (hash << 88)
+        uint64_t product0 = (low & 0xFFFFFFFF) * scPrimeLowPart;
+        uint64_t product1 = (low >> 32) * scPrimeLowPart + (product0 >> 32);
+        uint64_t newLow = (product1 << 32) | (product0 & 0xFFFFFFFF);
+        uint64_t newHigh = high * scPrimeLowPart + (product1 >> 32) + (low << 24);
+
+        high = newHigh;
+        low = newLow;
+    }
+}
+
+void ContentHash::Accumulate(const std::string& inString) {
+    Accumulate((long long)inString.size());
+    Accumulate((const Byte*)inString.c_str(), inString.size());
+}
+
+void ContentHash::Accumulate(long long inValue) {
+    Byte bytes[8];
+    for(int i = 0; i < 8; ++i)
+        bytes[i] = (Byte)((unsigned long long)inValue >> (i * 8));
+    Accumulate(bytes, 8);
+}
+
+void ContentHash::Accumulate(double inValue) {
+    uint64_t bits;
+    memcpy(&bits, &inValue, sizeof(bits));
+    Accumulate((long long)bits);
+}
+
+string ContentHash::ToHexString() const {
+    static const char scHexDigits[] = "0123456789abcdef";
+    string result;
+
+    for(int i = 60; i >= 0; i -= 4)
+        result += scHexDigits[(high >> i) & 0xF];
+    for(int i = 60; i >= 0; i -= 4)
+        result += scHexDigits[(low >> i) & 0xF];
+    return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "IOBasicTypes.h"
+
+#include <string>
+#include <stdint.h>
+
+/**
+ * ContentHash is a streaming 128 bit FNV-1a hash. it's used for keying cached extraction results by content,
+ * where 128 bits make collisions practically impossible, while being quick to compute.
+ **/
+class ContentHash {
+    public:
+        ContentHash();
+
+        void Accumulate(const IOBasicTypes::Byte* inBytes, size_t inLength);
+        // strings are accumulated with their length, so that a sequence of them hashes unambiguously
+        void Accumulate(const std::string& inString);
+        void Accumulate(long long inValue);
+        void Accumulate(double inValue);
+
+        std::string ToHexString() const;
+
+    private:
+        uint64_t high;
+        uint64_t low;
+};
@@ -0,0 +1,314 @@
+#include "ExtractionCache.h"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define MAKE_DIRECTORY(path) _mkdir(path)
+#define GET_PROCESS_ID() _getpid()
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAKE_DIRECTORY(path) mkdir(path, 0755)
+#define GET_PROCESS_ID() getpid()
+#endif
+
+using namespace std;
+
+// entries start with this, followed by the format version. bump the version when changing the layout below
+static const string scEntryMagic = "TXEC";
+static const uint32_t scEntryFormatVersion = 1;
+
+static const string scTextEntrySuffix = ".text";
+static const string scTablesEntrySuffix = ".tables";
+
+// serialization helpers. numbers are written little endian, so entries are portable between machines
+static void WriteUInt32(string& ioBuffer, uint32_t inValue) {
+    for(int i = 0; i < 4; ++i)
+        ioBuffer += (char)((inValue >> (i * 8)) & 0xFF);
+}
+
+static void WriteDouble(string& ioBuffer, double inValue) {
+    uint64_t bits;
+    memcpy(&bits, &inValue, sizeof(bits));
+    for(int i = 0; i < 8; ++i)
+        ioBuffer += (char)((bits >> (i * 8)) & 0xFF);
+}
+
+static void WriteDoubles(string& ioBuffer, const double* inValues, size_t inCount) {
+    for(size_t i = 0; i < inCount; ++i)
+        WriteDouble(ioBuffer, inValues[i]);
+}
+
+static void WriteString(string& ioBuffer, const string& inValue) {
+    WriteUInt32(ioBuffer, (uint32_t)inValue.size());
+    ioBuffer += inValue;
+}
+
+// reads from an entry content. once reading fails all following reads fail as well, so checking at the end is enough
+class EntryReader {
+    public:
+        EntryReader(const string& inContent):content(inContent) {
+            position = 0;
+            failed = false;
+        }
+
+        bool HasFailed() const {
+            return failed;
+        }
+
+        bool IsAtEnd() const {
+            return position == content.size();
+        }
+
+        uint32_t ReadUInt32() {
+            uint32_t result = 0;
+            if(!Ensure(4))
+                return result;
+            for(int i = 0; i < 4; ++i)
+                result |= ((uint32_t)(unsigned char)content[position + i]) << (i * 8);
+            position += 4;
+            return result;
+        }
+
+        double ReadDouble() {
+            uint64_t bits = 0;
+            double result = 0;
+            if(!Ensure(8))
+                return result;
+            for(int i = 0; i < 8; ++i)
+                bits |= ((uint64_t)(unsigned char)content[position + i]) << (i * 8);
+            position += 8;
+            memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        void ReadDoubles(double* outValues, size_t inCount) {
+            for(size_t i = 0; i < inCount; ++i)
+                outValues[i] = ReadDouble();
+        }
+
+        string ReadBytes(size_t inLength) {
+            if(!Ensure(inLength))
+                return string();
+            string result = content.substr(position, inLength);
+            position += inLength;
+            return result;
+        }
+
+        string ReadString() {
+            return ReadBytes(ReadUInt32());
+        }
+
+    private:
+        const string& content;
+        size_t position;
+        bool failed;
+
+        bool Ensure(size_t inLength) {
+            if(failed || content.size() - position < inLength)
+                failed = true;
+            return !failed;
+        }
+};
+
+static void WriteEntryHeader(string& ioBuffer) {
+    ioBuffer += scEntryMagic;
+    WriteUInt32(ioBuffer, scEntryFormatVersion);
+}
+
+static bool ReadEntryHeader(EntryReader& ioReader) {
+    if(ioReader.ReadBytes(scEntryMagic.size()) != scEntryMagic)
+        return false;
+    return ioReader.ReadUInt32() == scEntryFormatVersion && !ioReader.HasFailed();
+}
+
+static void WriteTextPlacements(string& ioBuffer, const ParsedTextPlacementList& inTextPlacements) {
+    WriteUInt32(ioBuffer, (uint32_t)inTextPlacements.size());
+
+    ParsedTextPlacementList::const_iterator it = inTextPlacements.begin();
+    for(; it != inTextPlacements.end(); ++it) {
+        WriteString(ioBuffer, it->text);
+        WriteDoubles(ioBuffer, it->matrix, 6);
+        WriteDoubles(ioBuffer, it->localBbox, 4);
+        WriteDoubles(ioBuffer, it->globalBbox, 4);
+        WriteDouble(ioBuffer, it->spaceWidth);
+        WriteDoubles(ioBuffer, it->globalSpaceWidth, 2);
+
+        WriteUInt32(ioBuffer, (uint32_t)it->parameters.formats.size());
+        set<TextFormat>::const_iterator itFormats = it->parameters.formats.begin();
+        for(; itFormats != it->parameters.formats.end(); ++itFormats)
+            WriteUInt32(ioBuffer, (uint32_t)*itFormats);
+        WriteDouble(ioBuffer, it->parameters.constantAlpha);
+    }
+}
+
+static bool ReadTextPlacements(EntryReader& ioReader, ParsedTextPlacementList& outTextPlacements) {
+    uint32_t count = ioReader.ReadUInt32();
+
+    for(uint32_t i = 0; i < count && !ioReader.HasFailed(); ++i) {
+        double matrix[6];
+        double localBbox[4];
+        double globalBbox[4];
+        double globalSpaceWidth[2];
+        TextParameters parameters;
+
+        string text = ioReader.ReadString();
+        ioReader.ReadDoubles(matrix, 6);
+        ioReader.ReadDoubles(localBbox, 4);
+        ioReader.ReadDoubles(globalBbox, 4);
+        double spaceWidth = ioReader.ReadDouble();
+        ioReader.ReadDoubles(globalSpaceWidth, 2);
+
+        uint32_t formatsCount = ioReader.ReadUInt32();
+        for(uint32_t j = 0; j < formatsCount && !ioReader.HasFailed(); ++j)
+            parameters.formats.insert((TextFormat)ioReader.ReadUInt32());
+        parameters.constantAlpha = ioReader.ReadDouble();
+
+        outTextPlacements.push_back(ParsedTextPlacement(text, matrix, localBbox, globalBbox, spaceWidth, globalSpaceWidth, parameters));
+    }
+
+    return !ioReader.HasFailed();
+}
+
+static void WriteLinePlacements(string& ioBuffer, const ParsedLinePlacementList& inLinePlacements) {
+    WriteUInt32(ioBuffer, (uint32_t)inLinePlacements.size());
+
+    ParsedLinePlacementList::const_iterator it = inLinePlacements.begin();
+    for(; it != inLinePlacements.end(); ++it) {
+        WriteUInt32(ioBuffer, it->isVertical ? 1 : 0);
+        WriteDoubles(ioBuffer, it->globalPointOne, 2);
+        WriteDoubles(ioBuffer, it->globalPointTwo, 2);
+        WriteDoubles(ioBuffer, it->effectiveLineWidth, 2);
+        WriteDoubles(ioBuffer, it->colorRGB, 3);
+    }
+}
+
+static bool ReadLinePlacements(EntryReader& ioReader, ParsedLinePlacementList& outLinePlacements) {
+    uint32_t count = ioReader.ReadUInt32();
+
+    for(uint32_t i = 0; i < count && !ioReader.HasFailed(); ++i) {
+        ParsedLinePlacement line;
+
+        line.isVertical = ioReader.ReadUInt32() != 0;
+        ioReader.ReadDoubles(line.globalPointOne, 2);
+        ioReader.ReadDoubles(line.globalPointTwo, 2);
+        ioReader.ReadDoubles(line.effectiveLineWidth, 2);
+        ioReader.ReadDoubles(line.colorRGB, 3);
+
+        outLinePlacements.push_back(line);
+    }
+
+    return !ioReader.HasFailed();
+}
+
+ExtractionCache::ExtractionCache(const string& inDirectory):temporaryFilesCount(0) {
+    directory = inDirectory;
+    if(!directory.empty() && directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\')
+        directory += '/';
+    MAKE_DIRECTORY(directory.c_str());
+}
+
+string ExtractionCache::GetEntryPath(const string& inKey) {
+    // spread entries between subdirectories by the key prefix, to avoid huge directories
+    return directory + inKey.substr(0, 2) + "/" + inKey;
+}
+
+bool ExtractionCache::ReadEntry(const string& inKey, string& outContent) {
+    ifstream entryFile(GetEntryPath(inKey).c_str(), ios::in | ios::binary);
+    if(!entryFile)
+        return false;
+
+    stringstream content;
+    content << entryFile.rdbuf();
+    if(entryFile.bad())
+        return false;
+
+    outContent = content.str();
+    return true;
+}
+
+void ExtractionCache::WriteEntry(const string& inKey, const string& inContent) {
+    string entryPath = GetEntryPath(inKey);
+    MAKE_DIRECTORY((directory + inKey.substr(0, 2)).c_str());
+
+    // temporary name unique between processes and threads, so concurrent writers don't mix
+    stringstream temporaryPath;
+    temporaryPath << entryPath << "." << GET_PROCESS_ID() << "." << hash<thread::id>()(this_thread::get_id()) << "." << temporaryFilesCount++ << ".tmp";
+
+    {
+        ofstream entryFile(temporaryPath.str().c_str(), ios::out | ios::binary | ios::trunc);
+        if(!entryFile)
+            return;
+        entryFile.write(inContent.c_str(), inContent.size());
+        if(!entryFile) {
+            entryFile.close();
+            remove(temporaryPath.str().c_str());
+            return;
+        }
+    }
+
+    // renaming may fail if another writer already placed this entry. that's fine, it has the same content
+    if(rename(temporaryPath.str().c_str(), entryPath.c_str()) != 0)
+        remove(temporaryPath.str().c_str());
+}
+
+bool ExtractionCache::LoadTextPlacements(const string& inKey, ParsedTextPlacementList& outTextPlacements) {
+    string content;
+    if(!ReadEntry(inKey + scTextEntrySuffix, content))
+        return false;
+
+    EntryReader reader(content);
+    ParsedTextPlacementList textPlacements;
+    if(!ReadEntryHeader(reader) || !ReadTextPlacements(reader, textPlacements) || !reader.IsAtEnd())
+        return false;
+
+    outTextPlacements.swap(textPlacements);
+    return true;
+}
+
+void ExtractionCache::StoreTextPlacements(const string& inKey, const ParsedTextPlacementList& inTextPlacements) {
+    string content;
+
+    WriteEntryHeader(content);
+    WriteTextPlacements(content, inTextPlacements);
+    WriteEntry(inKey + scTextEntrySuffix, content);
+}
+
+bool ExtractionCache::LoadTablePlacements(const string& inKey, ParsedTextPlacementList& outTextPlacements, Lines& outLines) {
+    string content;
+    if(!ReadEntry(inKey + scTablesEntrySuffix, content))
+        return false;
+
+    EntryReader reader(content);
+    ParsedTextPlacementList textPlacements;
+    Lines lines;
+    if(!ReadEntryHeader(reader) || 
+        !ReadTextPlacements(reader, textPlacements) || 
+        !ReadLinePlacements(reader, lines.verticalLines) ||
+        !ReadLinePlacements(reader, lines.horizontalLines) ||
+        !reader.IsAtEnd())
+        return false;
+
+    outTextPlacements.swap(textPlacements);
+    outLines.verticalLines.swap(lines.verticalLines);
+    outLines.horizontalLines.swap(lines.horizontalLines);
+    return true;
+}
+
+void ExtractionCache::StoreTablePlacements(const string& inKey, const ParsedTextPlacementList& inTextPlacements, const Lines& inLines) {
+    string content;
+
+    WriteEntryHeader(content);
+    WriteTextPlacements(content, inTextPlacements);
+    WriteLinePlacements(content, inLines.verticalLines);
+    WriteLinePlacements(content, inLines.horizontalLines);
+    WriteEntry(inKey + scTablesEntrySuffix, content);
+}
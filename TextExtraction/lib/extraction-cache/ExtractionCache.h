@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../text-parsing/ParsedTextPlacement.h"
+#include "../table-composition/Lines.h"
+
+#include <string>
+#include <atomic>
+
+/**
+ * ExtractionCache persists per page extraction results in a directory, keyed by page content (see PageContentHasher),
+ * so extracting a page that was already extracted before - from the same file, or any other file with the same page -
+ * skips interpretation and reads the results instead. entries are written to a temporary file and then renamed
+ * into place, so one cache directory can be shared by concurrent workers and processes.
+ * Failures to read or write entries are not errors - they're just cache misses.
+ **/
+class ExtractionCache {
+    public:
+        // the directory is created if it doesn't exist
+        ExtractionCache(const std::string& inDirectory);
+
+        // text extraction results of a page
+        bool LoadTextPlacements(const std::string& inKey, ParsedTextPlacementList& outTextPlacements);
+        void StoreTextPlacements(const std::string& inKey, const ParsedTextPlacementList& inTextPlacements);
+
+        // tables extraction results of a page, which are the text placements and the table lines of the page
+        bool LoadTablePlacements(const std::string& inKey, ParsedTextPlacementList& outTextPlacements, Lines& outLines);
+        void StoreTablePlacements(const std::string& inKey, const ParsedTextPlacementList& inTextPlacements, const Lines& inLines);
+
+    private:
+        std::string directory;
+        std::atomic<unsigned long> temporaryFilesCount;
+
+        std::string GetEntryPath(const std::string& inKey);
+        bool ReadEntry(const std::string& inKey, std::string& outContent);
+        void WriteEntry(const std::string& inKey, const std::string& inContent);
+};
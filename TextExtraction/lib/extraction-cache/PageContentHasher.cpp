@@ -0,0 +1,186 @@
+#include "PageContentHasher.h"
+#include "ContentHash.h"
+
+#include "PDFParser.h"
+#include "PDFObjectCast.h"
+#include "PDFDictionary.h"
+#include "PDFArray.h"
+#include "PDFName.h"
+#include "PDFBoolean.h"
+#include "PDFInteger.h"
+#include "PDFReal.h"
+#include "PDFLiteralString.h"
+#include "PDFHexString.h"
+#include "PDFSymbol.h"
+#include "PDFIndirectObjectReference.h"
+#include "PDFStreamInput.h"
+#include "IByteReader.h"
+#include "RefCountPtr.h"
+
+using namespace std;
+using namespace IOBasicTypes;
+
+// bump when changing what goes into keys, or how results are stored, so that older cache entries are not used
+static const string scKeyVersion = "1";
+
+static const string scResources = "Resources";
+static const string scContents = "Contents";
+static const string scParent = "Parent";
+static const string scSubtype = "Subtype";
+static const string scImage = "Image";
+
+static const size_t scStreamBufferSize = 65536;
+
+static PDFObject* FindInheritedResources(PDFParser* inParser, PDFDictionary* inDictionary) {
+    if(inDictionary->Exists(scResources))
+        return inParser->QueryDictionaryObject(inDictionary, scResources);
+
+    PDFObjectCastPtr<PDFDictionary> parentDict(
+        inDictionary->Exists(scParent) ?
+            inParser->QueryDictionaryObject(inDictionary, scParent):
+            NULL);
+    if(!parentDict)
+        return NULL;
+
+    return FindInheritedResources(inParser, parentDict.GetPtr());
+}
+
+PageContentHasher::PageContentHasher(PDFParser* inParser) {
+    parser = inParser;
+    streamBuffer.resize(scStreamBufferSize);
+}
+
+string PageContentHasher::ComputePageKey(PDFDictionary* inPage, const double (&inPageBox)[4], const string& inResultsKind) {
+    ContentHash hash;
+
+    hash.Accumulate(scKeyVersion);
+    hash.Accumulate(inResultsKind);
+    for(int i = 0; i < 4; ++i)
+        hash.Accumulate(inPageBox[i]);
+
+    hash.Accumulate(scContents);
+    AccumulateObject(hash, inPage->QueryDirectObject(scContents));
+
+    hash.Accumulate(scResources);
+    RefCountPtr<PDFObject> resources(FindInheritedResources(parser, inPage));
+    AccumulateObject(hash, resources.GetPtr());
+
+    return hash.ToHexString();
+}
+
+void PageContentHasher::AccumulateObject(ContentHash& ioHash, PDFObject* inObject) {
+    if(!inObject) {
+        ioHash.Accumulate((long long)-1);
+        return;
+    }
+
+    // QueryDirectObject and friends add a reference, so this one is owned
+    RefCountPtr<PDFObject> object(inObject);
+    ioHash.Accumulate((long long)inObject->GetType());
+
+    switch(inObject->GetType()) {
+        case PDFObject::ePDFObjectBoolean:
+            ioHash.Accumulate((long long)((PDFBoolean*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectLiteralString:
+            ioHash.Accumulate(((PDFLiteralString*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectHexString:
+            ioHash.Accumulate(((PDFHexString*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectName:
+            ioHash.Accumulate(((PDFName*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectInteger:
+            ioHash.Accumulate(((PDFInteger*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectReal:
+            ioHash.Accumulate(((PDFReal*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectSymbol:
+            ioHash.Accumulate(((PDFSymbol*)inObject)->GetValue());
+            break;
+        case PDFObject::ePDFObjectArray: {
+            PDFArray* anArray = (PDFArray*)inObject;
+            unsigned long length = anArray->GetLength();
+            ioHash.Accumulate((long long)length);
+            for(unsigned long i = 0; i < length; ++i)
+                AccumulateObject(ioHash, anArray->QueryObject(i));
+            break;
+        }
+        case PDFObject::ePDFObjectDictionary:
+            AccumulateDictionary(ioHash, (PDFDictionary*)inObject);
+            break;
+        case PDFObject::ePDFObjectIndirectObjectReference:
+            AccumulateIndirectObject(ioHash, ((PDFIndirectObjectReference*)inObject)->mObjectID);
+            break;
+        case PDFObject::ePDFObjectStream:
+            AccumulateStream(ioHash, (PDFStreamInput*)inObject);
+            break;
+        default:
+            break;
+    }
+}
+
+void PageContentHasher::AccumulateIndirectObject(ContentHash& ioHash, ObjectIDType inObjectID) {
+    map<ObjectIDType, string>::iterator it = objectsHashes.find(inObjectID);
+    if(it != objectsHashes.end()) {
+        ioHash.Accumulate(it->second);
+        return;
+    }
+
+    // object graphs may have cycles. a cycle back to an object is hashed by the object id, which
+    // is good enough, since a change in the object would still change the hash of its ancestor
+    if(objectsInProgress.find(inObjectID) != objectsInProgress.end()) {
+        ioHash.Accumulate((long long)inObjectID);
+        return;
+    }
+
+    objectsInProgress.insert(inObjectID);
+    ContentHash objectHash;
+    AccumulateObject(objectHash, parser->ParseNewObject(inObjectID));
+    objectsInProgress.erase(inObjectID);
+
+    string objectHashText = objectHash.ToHexString();
+    objectsHashes.insert(map<ObjectIDType, string>::value_type(inObjectID, objectHashText));
+    ioHash.Accumulate(objectHashText);
+}
+
+void PageContentHasher::AccumulateDictionary(ContentHash& ioHash, PDFDictionary* inDictionary) {
+    MapIterator<PDFNameToPDFObjectMap> it = inDictionary->GetIterator();
+
+    while(it.MoveNext()) {
+        // parents lead up the page tree, which would make every page depend on all others
+        if(it.GetKey()->GetValue() == scParent)
+            continue;
+
+        ioHash.Accumulate(it.GetKey()->GetValue());
+        PDFObject* value = it.GetValue();
+        value->AddRef();
+        AccumulateObject(ioHash, value);
+    }
+}
+
+void PageContentHasher::AccumulateStream(ContentHash& ioHash, PDFStreamInput* inStream) {
+    RefCountPtr<PDFDictionary> streamDictionary(inStream->QueryStreamDictionary());
+    AccumulateDictionary(ioHash, streamDictionary.GetPtr());
+
+    // image data doesn't affect extraction results, so skip reading it
+    PDFObjectCastPtr<PDFName> subtype(streamDictionary->QueryDirectObject(scSubtype));
+    if(!!subtype && subtype->GetValue() == scImage)
+        return;
+
+    // hash the stream bytes as stored. with the filters being part of the dictionary hash, they
+    // determine the decoded content just as well, without having to decode it
+    IByteReader* streamReader = parser->StartReadingFromStreamForPlainCopying(inStream);
+    if(!streamReader)
+        return;
+
+    while(streamReader->NotEnded()) {
+        LongBufferSizeType readAmount = streamReader->Read(&streamBuffer[0], streamBuffer.size());
+        if(readAmount == 0)
+            break;
+        ioHash.Accumulate(&streamBuffer[0], (size_t)readAmount);
+    }
+    delete streamReader;
+}
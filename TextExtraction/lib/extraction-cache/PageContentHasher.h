@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+
+#include "../pdf-writer-enhancers/Bytes.h"
+
+#include <string>
+#include <map>
+#include <set>
+
+class PDFParser;
+class PDFObject;
+class PDFDictionary;
+class PDFStreamInput;
+class ContentHash;
+
+/**
+ * PageContentHasher computes cache keys for pages, from what their extraction results depend on - the page
+ * content streams, its (inherited) resources, and the page box. objects are hashed by value, following references,
+ * and hashes of indirect objects are memoized, so objects shared between pages (fonts, forms) are only read once.
+ * use one hasher per parser, as memoization is by object id.
+ **/
+class PageContentHasher {
+    public:
+        PageContentHasher(PDFParser* inParser);
+
+        // inResultsKind distinguishes between different results computed for the same page (e.g. text vs tables).
+        std::string ComputePageKey(PDFDictionary* inPage, const double (&inPageBox)[4], const std::string& inResultsKind);
+
+    private:
+        PDFParser* parser;
+        std::map<ObjectIDType, std::string> objectsHashes;
+        std::set<ObjectIDType> objectsInProgress;
+        // for reading streams. on the heap and shared, as hashing recurses through nested forms and fonts (reading
+        // a stream's bytes doesn't recurse, so one buffer will do)
+        ByteVector streamBuffer;
+
+        void AccumulateObject(ContentHash& ioHash, PDFObject* inObject);
+        void AccumulateIndirectObject(ContentHash& ioHash, ObjectIDType inObjectID);
+        void AccumulateDictionary(ContentHash& ioHash, PDFDictionary* inDictionary);
+        void AccumulateStream(ContentHash& ioHash, PDFStreamInput* inStream);
+};
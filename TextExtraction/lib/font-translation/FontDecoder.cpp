@@ -28,10 +28,10 @@ static const string scSpace = "space";
 static const Encoding scEncoding;
 static const StandardFontsDimensions scStandardFontsDimensions;
 
-static unsigned long beToNum(const ByteList& inBytes) {
+static unsigned long beToNum(const ByteSpan& inBytes) {
     unsigned long result = 0;
 
-    for(ByteList::const_iterator it = inBytes.begin(); it != inBytes.end();++it){
+    for(const IOBasicTypes::Byte* it = inBytes.begin(); it != inBytes.end();++it){
         result = result*256 + *it;
     }
 
@@ -39,25 +39,20 @@ static unsigned long beToNum(const ByteList& inBytes) {
 
 }
 
-static ULongList besToUnicodes(const ByteList& inBytes) {
-    ByteList::const_iterator it = inBytes.begin();
+static ULongList besToUnicodes(const ByteSpan& inBytes) {
     ULongList unicodes;
 
-    while(it != inBytes.end()) {
-        ByteList buffer;
-        buffer.push_back(*it);
-        ++it;
-        buffer.push_back(*it);
-        ++it;
-        unsigned long newOne = beToNum(buffer);
+    // utf16be, two bytes at a time. a trailing odd byte is dropped
+    size_t i = 0;
+    while(i + 1 < inBytes.size) {
+        unsigned long newOne = beToNum(ByteSpan(inBytes.data + i, 2));
+        i += 2;
         if(0xD800 <= newOne && newOne <= 0xDBFF) {
-            buffer.clear();
-            buffer.push_back(*it);
-            ++it;
-            buffer.push_back(*it);
-            ++it;
+            if(i + 1 >= inBytes.size)
+                break;
             // pfff. high surrogate. need to read another one
-            unsigned long lowSurrogate = beToNum(buffer);
+            unsigned long lowSurrogate = beToNum(ByteSpan(inBytes.data + i, 2));
+            i += 2;
             unicodes.push_back(0x10000 + ((newOne - 0xD800) << 10) + (lowSurrogate - 0xDC00));
         } else {
             unicodes.push_back(newOne);
@@ -103,8 +98,8 @@ bool UnicodeMapReader::OnOperation(const std::string& inOperation, const PDFObje
         unsigned long limit = inOperands.size() - inOperands.size() % 2;
 
         for(unsigned long i=0;i<limit;i+=2) {
-            ByteList byteCode = ToBytesList(inOperands[i]);
-            ByteList unicodes = ToBytesList(inOperands[i+1]);
+            ByteVector byteCode = ToBytes(inOperands[i]);
+            ByteVector unicodes = ToBytes(inOperands[i+1]);
 
             result[beToNum(byteCode)] = besToUnicodes(unicodes);
         }
@@ -115,19 +110,19 @@ bool UnicodeMapReader::OnOperation(const std::string& inOperation, const PDFObje
         unsigned long limit = inOperands.size() - inOperands.size() % 3;
 
         for(unsigned long i=0;i<limit;i+=3) {
-            unsigned long startCode = beToNum(ToBytesList(inOperands[i]));
-            unsigned long endCode = beToNum(ToBytesList(inOperands[i+1]));
+            unsigned long startCode = beToNum(ToBytes(inOperands[i]));
+            unsigned long endCode = beToNum(ToBytes(inOperands[i+1]));
 
             if(inOperands[i+2]->GetType() == PDFObject::ePDFObjectArray) {
                 // specific codes
                 PDFArray* unicodeArray = (PDFArray*)inOperands[i+2];
                 for(unsigned long j=0;j<unicodeArray->GetLength();++j) {
-                    result[startCode+j] = besToUnicodes(ToBytesList(unicodeArray->QueryObject(j)));
+                    result[startCode+j] = besToUnicodes(ToBytes(unicodeArray->QueryObject(j)));
                 }
             }
             else {
                 // code range
-                ULongList unicodes = besToUnicodes(ToBytesList(inOperands[i+2]));
+                ULongList unicodes = besToUnicodes(ToBytes(inOperands[i+2]));
                 for(unsigned long j = startCode; j<=endCode;++j) {
                     result[j] = ULongList(unicodes);
                     ++unicodes.back();
@@ -367,9 +362,9 @@ Result<unsigned long> FontDecoder::FindSpaceCharGlyphCode() {
 }
 
 
-string FontDecoder::ToUnicodeEncoding(const ByteList& inAsBytes) {
+string FontDecoder::ToUnicodeEncoding(const ByteSpan& inAsBytes) {
     ULongList buffer;
-    ByteList::const_iterator it = inAsBytes.begin();
+    const IOBasicTypes::Byte* it = inAsBytes.begin();
 
     while(it != inAsBytes.end()) {
         unsigned long value = *it;
@@ -393,9 +388,9 @@ string FontDecoder::ToUnicodeEncoding(const ByteList& inAsBytes) {
     return UnicodeString(buffer).ToUTF8().second;
 }
 
-string FontDecoder::ToSimpleEncoding(const ByteList& inAsBytes) {
+string FontDecoder::ToSimpleEncoding(const ByteSpan& inAsBytes) {
     ULongList buffer;
-    ByteList::const_iterator it = inAsBytes.begin();
+    const IOBasicTypes::Byte* it = inAsBytes.begin();
 
     for(; it!= inAsBytes.end();++it) {
         ByteToStringMap::iterator entryIt = fromSimpleEncodingMap.find(*it);
@@ -411,13 +406,13 @@ string FontDecoder::ToSimpleEncoding(const ByteList& inAsBytes) {
     return UnicodeString(buffer).ToUTF8().second;
 }
 
-string FontDecoder::ToDefaultEncoding(const ByteList& inAsBytes) {
+string FontDecoder::ToDefaultEncoding(const ByteSpan& inAsBytes) {
     ULongList buffer(inAsBytes.begin(), inAsBytes.end());
 
     return UnicodeString(buffer).ToUTF8().second;
 }
 
-FontDecoderResult FontDecoder::Translate(const ByteList& inAsBytes) {
+FontDecoderResult FontDecoder::Translate(const ByteSpan& inAsBytes) {
     if(hasToUnicode) {
         FontDecoderResult res = {ToUnicodeEncoding(inAsBytes), eTranslationMethodToUnicode};
         return res;
@@ -440,9 +435,9 @@ double FontDecoder::GetCodeWidth(unsigned long inCode) {
         return it->second;
 }
 
-DispositionResultList FontDecoder::ComputeDisplacements(const ByteList& inAsBytes) {
+DispositionResultList FontDecoder::ComputeDisplacements(const ByteSpan& inAsBytes) {
     DispositionResultList result;
-    ByteList::const_iterator it = inAsBytes.begin();
+    const IOBasicTypes::Byte* it = inAsBytes.begin();
 
     if(isSimpleFont) {
         // one code per cells
@@ -35,8 +35,8 @@ class FontDecoder {
 public:
     FontDecoder(PDFParser* inParser, PDFDictionary* inFont);
 
-    FontDecoderResult Translate(const ByteList& inAsBytes);
-    DispositionResultList ComputeDisplacements(const ByteList& inAsBytes);
+    FontDecoderResult Translate(const ByteSpan& inAsBytes);
+    DispositionResultList ComputeDisplacements(const ByteSpan& inAsBytes);
 
     double ascent;
     double descent;
@@ -63,9 +63,9 @@ private:
     double GetCodeWidth(unsigned long inCode);
 
     // result is utf8 encoded!
-    std::string ToUnicodeEncoding(const ByteList& inAsBytes);
-    std::string ToSimpleEncoding(const ByteList& inAsBytes);
-    std::string ToDefaultEncoding(const ByteList& inAsBytes);
+    std::string ToUnicodeEncoding(const ByteSpan& inAsBytes);
+    std::string ToSimpleEncoding(const ByteSpan& inAsBytes);
+    std::string ToDefaultEncoding(const ByteSpan& inAsBytes);
 
     Result<unsigned long> FindSpaceCharGlyphCode();
 
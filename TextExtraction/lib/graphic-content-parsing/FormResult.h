@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+
+#include "TextElement.h"
+#include "PathElement.h"
+#include "TextGraphicState.h"
+
+#include "../text-parsing/ParsedTextPlacement.h"
+
+#include <list>
+#include <map>
+
+// FormResultItem is a single output of a form, either a text element or a painted path.
+// graphic states ctms are relative to the form placement (so in form space), and should be multiplied
+// by the placement ctm to get the ctms of a placement.
+struct FormResultItem {
+    bool isText;
+
+    // text data
+    TextElement textElement;
+    TextParameters textParameters;
+
+    // path data
+    PathElement pathElement;
+};
+
+typedef std::list<FormResultItem> FormResultItemList;
+
+// FormResult is the output of a form for a particular entry state. a form may use whatever
+// font, color or line width were set prior to its placement, so the same form may have different results
+struct FormResult {
+    FormResult() {
+        lineWidth = 1;
+        ZeroVector(colorRGB);
+        ZeroVector(exitColorRGB);
+        placementsCount = 0;
+        isCacheable = true;
+        isReady = false;
+    }
+
+    // entry state
+    TextGraphicState textState;
+    double lineWidth;
+    double colorRGB[3];
+
+    // output. available once ready
+    FormResultItemList items;
+    // color is the only state that leaks out of a form
+    double exitColorRGB[3];
+
+    unsigned long placementsCount;
+    bool isCacheable;
+    bool isReady;
+};
+
+typedef std::list<FormResult> FormResultList;
+typedef std::map<ObjectIDType, FormResultList> ObjectIDTypeToFormResultListMap;
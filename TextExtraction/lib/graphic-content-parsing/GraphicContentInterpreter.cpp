@@ -14,12 +14,72 @@
 #include "../interpreter/PDFRecursiveInterpreter.h"
 #include "../pdf-writer-enhancers/Bytes.h"
 
+#include <algorithm>
 
 using namespace std;
 
+static ByteSpan ToBytes(const ContentOperandStack& inOperands, const ContentOperand& inOperand) {
+    if(inOperand.type != eContentOperandString)
+        return ByteSpan();
+
+    return ByteSpan(inOperands.GetBytes(inOperand), inOperand.length);
+}
+
+static void TransformStates(TextElement& ioTextElement, const double (&inMatrix)[6]) {
+    double buffer[6];
+
+    PlacedTextCommandList::iterator it = ioTextElement.texts.begin();
+    for(; it != ioTextElement.texts.end(); ++it) {
+        MultiplyMatrix(it->graphicState.ctm, inMatrix, buffer);
+        CopyMatrix(buffer, it->graphicState.ctm);
+    }
+}
+
+static void TransformStates(PathElement& ioPathElement, const double (&inMatrix)[6]) {
+    double buffer[6];
+
+    MultiplyMatrix(ioPathElement.graphicState.ctm, inMatrix, buffer);
+    CopyMatrix(buffer, ioPathElement.graphicState.ctm);
+}
+
+static bool IsSameMatrix(const double (&inMatrixA)[6], const double (&inMatrixB)[6]) {
+    for(int i=0;i<6;++i) {
+        if(inMatrixA[i] != inMatrixB[i])
+            return false;
+    }
+    return true;
+}
+
 GraphicContentInterpreter::GraphicContentInterpreter(void) {
     handler = NULL;
+    cancellationToken = NULL;
+    contentPrefetcher = NULL;
+    regions = NULL;
     isInTextElement = false;
+    isBufferingTextElement = true;
+    isTextElementStart = false;
+    hasTextRun = false;
+    isTextRunInRegions = true;
+    stopRequested = false;
+    interests = eGraphicContentInterestAll;
+    shouldRecordTexts = true;
+    shouldStreamTexts = false;
+    shouldBuildPaths = true;
+    shouldTrackColors = true;
+    cachedResultsParser = NULL;
+    cachedResultsInterests = eGraphicContentInterestAll;
+}
+
+void GraphicContentInterpreter::SetCancellationToken(const CancellationToken* inCancellationToken) {
+    cancellationToken = inCancellationToken;
+}
+
+void GraphicContentInterpreter::SetContentPrefetcher(ContentPrefetcher* inContentPrefetcher) {
+    contentPrefetcher = inContentPrefetcher;
+}
+
+void GraphicContentInterpreter::SetRegions(const RegionBoxList* inRegions) {
+    regions = inRegions;
 }
 
 GraphicContentInterpreter::~GraphicContentInterpreter(void) {
@@ -34,11 +94,40 @@ bool GraphicContentInterpreter::InterpretPageContents(
     if(!inHandler) // yeah im gonna require a handler here.
         return true;
 
-    PDFRecursiveInterpreter interpreter;
+    // interpreter specific to this handler, so operations are dispatched to it with no virtual calls
+    PDFRecursiveInterpreterT<GraphicContentInterpreter> interpreter;
+    interpreter.SetCancellationToken(cancellationToken);
+    interpreter.SetContentPrefetcher(contentPrefetcher);
+
+    interests = inHandler->GetInterests();
+    shouldStreamTexts = (interests & eGraphicContentInterestTextCommands) != 0;
+    shouldRecordTexts = shouldStreamTexts || (interests & eGraphicContentInterestText) != 0;
+    shouldBuildPaths = (interests & eGraphicContentInterestPaths) != 0;
+    shouldTrackColors = shouldBuildPaths && (interests & eGraphicContentInterestColors) != 0;
+
+    if(cachedResultsParser != inParser || cachedResultsInterests != interests) {
+        // shared resources and forms results are per object ids of a particular parser. forms results
+        // also only have what the handler was interested in
+        formResults.clear();
+        sharedResources.clear();
+        fonts.clear();
+        fontsByObjectID.clear();
+        cachedResultsParser = inParser;
+        cachedResultsInterests = interests;
+    }
 
     handler = inHandler;
     InitInterpretationState();
-    bool result = interpreter.InterpretPageContents(inParser, inPage, this);
+    bool result = interpreter.InterpretPageContents(inParser, inPage, this) && !stopRequested;
+    if(!result) {
+        // interpretation was cut short, so results recorded in this page may be partial. drop them
+        FormResultPtrList::iterator it = formResultsReadyInPage.begin();
+        for(; it != formResultsReadyInPage.end(); ++it) {
+            (*it)->items.clear();
+            (*it)->isReady = false;
+        }
+    }
+    formResultsReadyInPage.clear();
     ResetInterpretationState();
     return result;
 }
@@ -49,7 +138,7 @@ void GraphicContentInterpreter::InitInterpretationState() {
 }
 
 void GraphicContentInterpreter::ClearCurrentPath() {
-    currentPath.subPaths.clear();
+    currentPath.Clear();
 }
 
 void GraphicContentInterpreter::ResetInterpretationState() {
@@ -57,110 +146,149 @@ void GraphicContentInterpreter::ResetInterpretationState() {
 
     ClearCurrentPath();
     resourcesStack.clear();
+    contentResources.clear();
     graphicStateStack.clear();
     textGraphicStateStack.clear();
     isInTextElement = false;
     currentTextElementCommands.clear();
+    formPlacementsStack.clear();
+    stopRequested = false;
 }
 
 
-bool GraphicContentInterpreter::OnOperation(const std::string& inOperation,  const PDFObjectVector& inOperands, IInterpreterContext* inContext) {
-    if (inOperation == "q") {
+bool GraphicContentInterpreter::OnOperation(EContentOperator inOperator, const std::string& inOperation,  const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
+    if(stopRequested) // handler asked to stop while replaying a form
+        return false;
+
+    switch(inOperator) {
         // graphic state operators
-        return qCommand();
-    } else if(inOperation == "Q") {
-        return QCommand();
-    } else if(inOperation == "cm") {
-        return cmCommand(inOperands);
-    } else if(inOperation == "w") {
-        return wCommand(inOperands);
-    } else if(inOperation == "gs") {
-        return gsCommand(inOperands, inContext);
-    } else if(inOperation == "Tc") {
+        case eOperatorq:
+            return qCommand();
+        case eOperatorQ:
+            return QCommand();
+        case eOperatorcm:
+            return cmCommand(inOperands);
+        case eOperatorw:
+            return wCommand(inOperands);
+        case eOperatorgs:
+            return gsCommand(inOperands, inContext);
+
         // text state operators
-        return TcCommand(inOperands);
-    } else if(inOperation == "Tw") {
-        return TwCommand(inOperands);
-    } else if(inOperation == "Tz") {
-        return TzCommand(inOperands);
-    } else if(inOperation == "TL") {
-        return TLCommand(inOperands);
-    } else if(inOperation == "Ts") {
-        return TsCommand(inOperands);
-    } else if(inOperation == "Tf") {
-        return TfCommand(inOperands, inContext);
-    } else if(inOperation == "BT") {
-        return BTCommand();
-    } else if(inOperation == "ET") {
-         return ETCommand(inContext);
-    } else if(inOperation == "Td") {
+        case eOperatorTc:
+            return TcCommand(inOperands);
+        case eOperatorTw:
+            return TwCommand(inOperands);
+        case eOperatorTz:
+            return TzCommand(inOperands);
+        case eOperatorTL:
+            return TLCommand(inOperands);
+        case eOperatorTs:
+            return TsCommand(inOperands);
+        case eOperatorTf:
+            return TfCommand(inOperands, inContext);
+        case eOperatorBT:
+            return BTCommand();
+        case eOperatorET:
+            return ETCommand(inContext);
+
         // text positioining operators
-        return TdCommand(inOperands);
-    } else if(inOperation == "TD") {
-        return TDCommand(inOperands);
-    } else if(inOperation == "Tm") {
-        return TmCommand(inOperands);
-    } else if(inOperation == "T*") {
-        return TStarCommand();
-    } else if(inOperation == "Tj") {
+        case eOperatorTd:
+            return TdCommand(inOperands);
+        case eOperatorTD:
+            return TDCommand(inOperands);
+        case eOperatorTm:
+            return TmCommand(inOperands);
+        case eOperatorTStar:
+            return TStarCommand();
+
         // text placement operators
-        return TjCommand(inOperands);
-    } else if(inOperation == "\'") {
-        return QuoteCommand(inOperands);
-    } else if(inOperation == "\"") {
-        return DoubleQuoteCommand(inOperands);
-    } else if(inOperation == "TJ") {
-        return TJCommand(inOperands);
-    } else if(inOperation == "m") {
+        case eOperatorTj:
+            return !shouldRecordTexts || TjCommand(inOperands, inContext);
+        case eOperatorQuote:
+            return !shouldRecordTexts || QuoteCommand(inOperands, inContext);
+        case eOperatorDoubleQuote:
+            return !shouldRecordTexts || DoubleQuoteCommand(inOperands, inContext);
+        case eOperatorTJ:
+            return !shouldRecordTexts || TJCommand(inOperands, inContext);
+
+        // path construction and painting operators
+        case eOperatorm:
+        case eOperatorl:
+        case eOperatorc:
+        case eOperatorv:
+        case eOperatory:
+        case eOperatorh:
+        case eOperatorre:
+        case eOperatorS:
+        case eOperators:
+        case eOperatorf:
+        case eOperatorF:
+        case eOperatorfStar:
+        case eOperatorB:
+        case eOperatorBStar:
+        case eOperatorb:
+        case eOperatorbStar:
+        case eOperatorn:
+            return !shouldBuildPaths || OnPathOperation(inOperator, inOperands);
+
+        // color operators
+        case eOperatorscn:
+        case eOperatorrg:
+            return !shouldTrackColors || setCurrentColor(inOperands);
+
+        default:
+            return true;
+    }
+}
+
+bool GraphicContentInterpreter::OnPathOperation(EContentOperator inOperator, const ContentOperandStack& inOperands) {
+    switch(inOperator) {
         // path construction operators
-        return mCommand(inOperands);
-    } else if(inOperation == "l") {
-        return lCommand(inOperands);
-    } else if(inOperation == "c") {
-        return cCommand(inOperands);
-    } else if(inOperation == "v") {
-        return vCommand(inOperands);
-    } else if(inOperation == "y") {
-        return yCommand(inOperands);
-    } else if(inOperation == "h") {
-        return hCommand(inOperands);
-    } else if(inOperation == "re") {
-        return reCommand(inOperands);
-    } else if(inOperation == "S") {
+        case eOperatorm:
+            return mCommand(inOperands);
+        case eOperatorl:
+            return lCommand(inOperands);
+        case eOperatorc:
+            return cCommand(inOperands);
+        case eOperatorv:
+            return vCommand(inOperands);
+        case eOperatory:
+            return yCommand(inOperands);
+        case eOperatorh:
+            return hCommand(inOperands);
+        case eOperatorre:
+            return reCommand(inOperands);
+
         // path painting operators
-        return SCommand(inOperands);
-    } else if(inOperation == "s") {
-        return sCommand(inOperands);
-    } else if(inOperation == "f") {
-        return fCommand(inOperands);
-    } else if(inOperation == "F") {
-        // used for compatibility...equivalent to "f"
-        return fCommand(inOperands);
-    } else if(inOperation == "f*") {
-        return fStarCommand(inOperands);
-    } else if(inOperation == "B") {
-        return BCommand(inOperands);
-    } else if(inOperation == "B*") {
-        return BStarCommand(inOperands);
-    } else if(inOperation == "b") {
-        return bCommand(inOperands);
-    } else if(inOperation == "b*") {
-        return bStarCommand(inOperands);
-    } else if(inOperation == "n") {
-        return nCommand(inOperands);
-    } else if(inOperation == "scn") {
-        return setCurrentColor(inOperands);
-    } else if(inOperation == "rg") {
-        return setCurrentColor(inOperands);
+        case eOperatorS:
+            return SCommand(inOperands);
+        case eOperators:
+            return sCommand(inOperands);
+        case eOperatorf:
+        case eOperatorF: // used for compatibility...equivalent to "f"
+            return fCommand(inOperands);
+        case eOperatorfStar:
+            return fStarCommand(inOperands);
+        case eOperatorB:
+            return BCommand(inOperands);
+        case eOperatorBStar:
+            return BStarCommand(inOperands);
+        case eOperatorb:
+            return bCommand(inOperands);
+        case eOperatorbStar:
+            return bStarCommand(inOperands);
+        case eOperatorn:
+            return nCommand(inOperands);
+
+        default:
+            return true;
     }
-
-    return true;
 }
 
 void GraphicContentInterpreter::PushGraphicState() {
-    graphicStateStack.push_back(ContentGraphicState(graphicStateStack.back()));
+    graphicStateStack.push_back(graphicStateStack.back());
     if(isInTextElement)
-        textGraphicStateStack.push_back(TextGraphicState(textGraphicStateStack.back()));    
+        textGraphicStateStack.push_back(textGraphicStateStack.back());
 }
 
 bool GraphicContentInterpreter::qCommand() {
@@ -192,23 +320,23 @@ void GraphicContentInterpreter::cm(const double (&matrix)[6]) {
     CopyMatrix(buffer, CurrentGraphicState().ctm);
 }
 
-bool GraphicContentInterpreter::cmCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::cmCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 6)
         return true; // too few params? ignore
 
     double matrix[6];
     for(int i=0;i<6;++i) {
-            matrix[i] = ParsedPrimitiveHelper(inOperands[i]).GetAsDouble();
+            matrix[i] = inOperands.GetNumber(i);
     }
     cm(matrix);
     return true;
 }
 
-bool GraphicContentInterpreter::wCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::wCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    CurrentGraphicState().lineWidth = ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    CurrentGraphicState().lineWidth = inOperands.GetNumber(inOperands.size()-1);
     return true;
 }
 
@@ -220,12 +348,12 @@ TextGraphicState& GraphicContentInterpreter::CurrentTextState() {
     return graphicStateStack.back().textGraphicState;
 }
 
-bool GraphicContentInterpreter::gsCommand(const PDFObjectVector& inOperands, IInterpreterContext* inContext) {
+bool GraphicContentInterpreter::gsCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    string gsName = ParsedPrimitiveHelper(inOperands.back()).ToString();
-    Resources& currentResources = resourcesStack.back();
+    string gsName = inOperands.GetText(inOperands.size()-1);
+    Resources& currentResources = *resourcesStack.back();
 
     StringToGStateMap::iterator it = currentResources.gStates.find(gsName);
     if(it != currentResources.gStates.end()) {
@@ -239,8 +367,9 @@ bool GraphicContentInterpreter::gsCommand(const PDFObjectVector& inOperands, IIn
         }
     } // gstate will not be found if name is wrong, or that it didn't get collected cause didn't have interesting info for the task at hand
 
-    if (inContext) {
-        inContext->textParameters.constantAlpha = inContext->GetParser()->GetConstantAplha(gsName);
+    if (inContext && shouldRecordTexts) {
+        // read once with the resources
+        inContext->textParameters.constantAlpha = it != currentResources.gStates.end() ? it->second.constantAlpha : 1;
     }
     return true;
 }
@@ -249,11 +378,11 @@ void GraphicContentInterpreter::Tc(double inCharSpace) {
     CurrentTextState().charSpace = inCharSpace;
 }
 
-bool GraphicContentInterpreter::TcCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TcCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    Tc(ParsedPrimitiveHelper(inOperands.back()).GetAsDouble());
+    Tc(inOperands.GetNumber(inOperands.size()-1));
     return true;
 }
 
@@ -261,19 +390,19 @@ void GraphicContentInterpreter::Tw(double inWordSpace) {
     CurrentTextState().wordSpace = inWordSpace;
 }
 
-bool GraphicContentInterpreter::TwCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TwCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    Tw(ParsedPrimitiveHelper(inOperands.back()).GetAsDouble());
+    Tw(inOperands.GetNumber(inOperands.size()-1));
     return true;
 }
 
-bool GraphicContentInterpreter::TzCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TzCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    CurrentTextState().scale = ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    CurrentTextState().scale = inOperands.GetNumber(inOperands.size()-1);
     return true;
 }
 
@@ -281,53 +410,48 @@ void GraphicContentInterpreter::TL(double inLeading) {
     CurrentTextState().leading = inLeading;
 }
 
-bool GraphicContentInterpreter::TLCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TLCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    TL(ParsedPrimitiveHelper(inOperands.back()).GetAsDouble());        
+    TL(inOperands.GetNumber(inOperands.size()-1));        
     return true;
 }
 
 
-bool GraphicContentInterpreter::TsCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TsCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    CurrentTextState().rise = ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    CurrentTextState().rise = inOperands.GetNumber(inOperands.size()-1);
     return true;
 }
 
-bool GraphicContentInterpreter::TfCommand(const PDFObjectVector& inOperands, IInterpreterContext* inContext) {
+bool GraphicContentInterpreter::TfCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    double size = ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    double size = inOperands.GetNumber(inOperands.size()-1);
+    const Font* font = NULL;
     if(inOperands.size() > 1) {
-        string fontName = ParsedPrimitiveHelper(inOperands[inOperands.size()-2]).ToString();
-        Resources& currentResources = resourcesStack.back();
+        string fontName = inOperands.GetText(inOperands.size()-2);
+        Resources& currentResources = *resourcesStack.back();
 
         StringToFontMap::iterator it = currentResources.fonts.find(fontName);
         if(it != currentResources.fonts.end()) {
             CurrentTextState().fontRef = it->second.fontRef;
+            font = &(it->second);
         } // should i have a default font policy here?! 80-20 gal, 80-20.
     }
     CurrentTextState().fontSize = size;
 
-    if (inContext) {
+    if (inContext && shouldRecordTexts) {
+        // style was figured out once with the resources
         inContext->textParameters.clear();
-        if (inOperands.size() > 1) {
-            const PDFName* currentFont = (PDFName*)inOperands.at(inOperands.size() - 2);
-            const auto baseFont = inContext->GetParser()->GetBaseFontName(currentFont);
-            if (baseFont.find("Bold") != std::string::npos
-                || baseFont.find("bold") != std::string::npos) {
-                inContext->textParameters.formats.insert(TextFormat::Bold);
-            }
-            if (baseFont.find("Italic") != std::string::npos
-                || baseFont.find("italic") != std::string::npos) {
-                inContext->textParameters.formats.insert(TextFormat::Italic);
-            }
-        }
+        if (!!font && font->isBold)
+            inContext->textParameters.formats.insert(TextFormat::Bold);
+        if (!!font && font->isItalic)
+            inContext->textParameters.formats.insert(TextFormat::Italic);
     }
 
     return true;
@@ -335,9 +459,13 @@ bool GraphicContentInterpreter::TfCommand(const PDFObjectVector& inOperands, IIn
 
 void GraphicContentInterpreter::StartTextElement() {
     isInTextElement = true;
+    // forms are only recorded from outside of text elements, so whether a form needs this element is known already
+    isBufferingTextElement = !shouldStreamTexts || IsRecordingForm();
+    isTextElementStart = true;
+    hasTextRun = false;
     currentTextElementCommands.clear();
     textGraphicStateStack.clear();
-    textGraphicStateStack.push_back(TextGraphicState(graphicStateStack.back().textGraphicState));
+    textGraphicStateStack.push_back(graphicStateStack.back().textGraphicState);
 }
 
 
@@ -364,16 +492,27 @@ bool GraphicContentInterpreter::EndTextElement(IInterpreterContext* inContext) {
     target.fontRef = source.fontRef;
     target.fontSize = source.fontSize;
 
-    // prep result
-    TextElement el = {PlacedTextCommandList(currentTextElementCommands)};
+    // prep result. the commands are moved to it, no copying
+    TextElement el;
+    el.texts.swap(currentTextElementCommands);
 
     // clear text element state
-    currentTextElementCommands.clear();
     textGraphicStateStack.clear();
 
-    // forward the new text element to the client
+    if(!shouldRecordTexts)
+        return true;
+
     TextParameters parameters = inContext ? inContext->textParameters : TextParameters{};
-    return handler->OnTextElementComplete(el, parameters);
+
+    // streamed texts were already forwarded command by command. just the forms being recorded may need the element
+    if(shouldStreamTexts) {
+        if(isBufferingTextElement)
+            RecordFormsTextElement(el, parameters);
+        return true;
+    }
+
+    // forward the new text element to the client
+    return EmitTextElement(el, parameters);
 }
 
 bool GraphicContentInterpreter::ETCommand(IInterpreterContext* inContext) {
@@ -400,33 +539,33 @@ void GraphicContentInterpreter::Td(double inX, double inY) {
     setTm(result);
 }
 
-bool GraphicContentInterpreter::TdCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TdCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 2)
         return true; // too few params? ignore
 
-    Td(ParsedPrimitiveHelper(inOperands[inOperands.size()-2]).GetAsDouble(), ParsedPrimitiveHelper(inOperands.back()).GetAsDouble());
+    Td(inOperands.GetNumber(inOperands.size()-2), inOperands.GetNumber(inOperands.size()-1));
     return true;
 }
 
-bool GraphicContentInterpreter::TDCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TDCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 2)
         return true; // too few params? ignore
 
-    double param1 = ParsedPrimitiveHelper(inOperands[inOperands.size()-2]).GetAsDouble();
-    double param2 =  ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    double param1 = inOperands.GetNumber(inOperands.size()-2);
+    double param2 =  inOperands.GetNumber(inOperands.size()-1);
     TL(-param2);
     Td(param1, param2);
     return true;
 }
 
-bool GraphicContentInterpreter::TmCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TmCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 6)
         return true; // too few params? ignore
 
     double matrix[6];
 
     for(int i=0;i<6;++i) {
-        matrix[i] = ParsedPrimitiveHelper(inOperands[i]).GetAsDouble();
+        matrix[i] = inOperands.GetNumber(i);
     }  
     setTm(matrix);      
     return true;
@@ -445,92 +584,101 @@ bool GraphicContentInterpreter::TStarCommand() {
     return true;
 }
 
-void GraphicContentInterpreter::RecordTextPlacement(const PlacedTextCommandArgument& inTextPlacementOperation) {
+bool GraphicContentInterpreter::RecordTextPlacement(const PlacedTextCommandArgument& inTextPlacementOperation, IInterpreterContext* inContext) {
     PlacedTextCommandArgumentList placements;
     placements.push_back(inTextPlacementOperation);
-    RecordTextPlacement(placements);
+    return RecordTextPlacement(placements, inContext);
 }
 
-void GraphicContentInterpreter::RecordTextPlacement(const PlacedTextCommandArgumentList& inTextPlacementOperations) {
-    PlacedTextCommand el = {
+bool GraphicContentInterpreter::RecordTextPlacement(const PlacedTextCommandArgumentList& inTextPlacementOperations, IInterpreterContext* inContext) {
+    if(!isInTextElement)
+        return true; // placed outside of a text element. the BT starting the next element would drop it anyways
+
+    if(isBufferingTextElement) {
+        PlacedTextCommand el = {
+            inTextPlacementOperations,
+            ContentGraphicState(CurrentGraphicState()),
+            TextGraphicState(CurrentTextState())
+        };
+        currentTextElementCommands.push_back(el);
+    }
+
+    if(!shouldStreamTexts)
+        return true;
+
+    // forward the command right away, with the current states
+    return EmitTextCommand(
         inTextPlacementOperations,
-        ContentGraphicState(CurrentGraphicState()),
-        TextGraphicState(CurrentTextState())
-    };
-    currentTextElementCommands.push_back(el);
+        CurrentGraphicState(),
+        CurrentTextState(),
+        inContext ? inContext->textParameters : TextParameters{});
 }
 
-bool GraphicContentInterpreter::TjCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TjCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    RecordTextPlacement(PlacedTextCommandArgument(ToBytesList(inOperands.back())));
-    return true;
+    return RecordTextPlacement(PlacedTextCommandArgument(ToBytes(inOperands, inOperands.back())), inContext);
 }
 
-void GraphicContentInterpreter::Quote(PDFObject* inObject) {
+bool GraphicContentInterpreter::Quote(const ContentOperandStack& inOperands, const ContentOperand& inText, IInterpreterContext* inContext) {
     TStar();
-    RecordTextPlacement(PlacedTextCommandArgument(ToBytesList(inObject)));        
+    return RecordTextPlacement(PlacedTextCommandArgument(ToBytes(inOperands, inText)), inContext);
 }
 
-bool GraphicContentInterpreter::QuoteCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::QuoteCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
 
-    Quote(inOperands.back());
-    return true;
+    return Quote(inOperands, inOperands.back(), inContext);
 }
 
-bool GraphicContentInterpreter::DoubleQuoteCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::DoubleQuoteCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
     if(inOperands.size() < 3)
         return true; // too few params? ignore
 
-    Tw(ParsedPrimitiveHelper(inOperands[inOperands.size()-3]).GetAsDouble());
-    Tc(ParsedPrimitiveHelper(inOperands[inOperands.size()-2]).GetAsDouble());
-    Quote(inOperands.back());
-    return true;
+    Tw(inOperands.GetNumber(inOperands.size()-3));
+    Tc(inOperands.GetNumber(inOperands.size()-2));
+    return Quote(inOperands, inOperands.back(), inContext);
 }
 
-bool GraphicContentInterpreter::TJCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::TJCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
     
     PlacedTextCommandArgumentList placements;
-    PDFObjectCastPtr<PDFArray> arg;
+    const ContentOperand& arg = inOperands.back();
 
-    arg = inOperands.back();
-    if(!arg)
+    if(arg.type != eContentOperandArray)
         return true;
-    SingleValueContainerIterator<PDFObjectVector> it = arg->GetIterator();
-    while(it.MoveNext()) {
-        PDFObject* item = it.GetItem();
-        if(item->GetType() == PDFObject::ePDFObjectLiteralString || item->GetType() == PDFObject::ePDFObjectHexString) {
-            string asEncodedText = ParsedPrimitiveHelper(item).ToString();
-            ByteList asBytes = ToBytesList(item);
-            placements.push_back(PlacedTextCommandArgument(asBytes));
+    for(size_t i = 0; i < arg.length; ++i) {
+        const ContentOperand& item = inOperands.GetArrayItem(arg, i);
+        if(item.type == eContentOperandString) {
+            placements.push_back(PlacedTextCommandArgument(ToBytes(inOperands, item)));
         }
         else {
-            placements.push_back(PlacedTextCommandArgument(ParsedPrimitiveHelper(item).GetAsDouble()));
+            placements.push_back(PlacedTextCommandArgument(inOperands.GetNumber(item)));
         }
     }
 
-    RecordTextPlacement(placements);
-    return true;
+    return RecordTextPlacement(placements, inContext);
 }
 
 void GraphicContentInterpreter::StartNewSubpathWithPoint(const PathPoint& inPoint) {
     SubPath newSubPath;
 
-    newSubPath.components.push_back(PathComponent(inPoint));
+    newSubPath.firstComponent = currentPath.components.size();
+    newSubPath.componentsCount = 1;
+    currentPath.components.push_back(PathComponent(inPoint));
     currentPath.subPaths.push_back(newSubPath);
 }
 
-bool GraphicContentInterpreter::mCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::mCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 2)
         return true; // too few params? ignore
 
-    double x = ParsedPrimitiveHelper(inOperands[inOperands.size()-2]).GetAsDouble();
-    double y =  ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    double x = inOperands.GetNumber(inOperands.size()-2);
+    double y =  inOperands.GetNumber(inOperands.size()-1);
 
     StartNewSubpathWithPoint(PathPoint(x,y));
 
@@ -538,7 +686,7 @@ bool GraphicContentInterpreter::mCommand(const PDFObjectVector& inOperands) {
 }
 
 bool GraphicContentInterpreter::NoCurrentPoint() {
-    return currentPath.subPaths.size() == 0 || currentPath.subPaths.back().components.size() == 0;
+    return currentPath.subPaths.size() == 0 || currentPath.subPaths.back().componentsCount == 0;
 }
 
 bool GraphicContentInterpreter::AppendComponentToCurrentPath(const PathComponent& inComponent) {
@@ -549,58 +697,58 @@ bool GraphicContentInterpreter::AppendComponentToCurrentPath(const PathComponent
     // subpath using the current point as first point and then add the new path component...or if it's
     // open in which case we can just append the new component to the current subpath
 
-    SubPath& currentSubPath = currentPath.subPaths.back();
-
-    if(currentSubPath.isClosed) {
-        StartNewSubpathWithPoint(currentSubPath.components.back().to);
+    // the current subpath is the last one, so its components are the last ones
+    if(currentPath.subPaths.back().isClosed) {
+        StartNewSubpathWithPoint(currentPath.components.back().to);
     }
 
-    currentPath.subPaths.back().components.push_back(inComponent);
+    currentPath.components.push_back(inComponent);
+    ++currentPath.subPaths.back().componentsCount;
 
     return true;
  }
 
-bool GraphicContentInterpreter::lCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::lCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 2)
         return true; // too few params? ignore
 
-    double x = ParsedPrimitiveHelper(inOperands[inOperands.size()-2]).GetAsDouble();
-    double y =  ParsedPrimitiveHelper(inOperands.back()).GetAsDouble();
+    double x = inOperands.GetNumber(inOperands.size()-2);
+    double y =  inOperands.GetNumber(inOperands.size()-1);
 
     return AppendComponentToCurrentPath(PathComponent(PathPoint(x,y)));
 }
 
-bool GraphicContentInterpreter::cCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::cCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 6)
         return true; // too few params? ignore
 
-    PathPoint control1(ParsedPrimitiveHelper(inOperands[0]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[1]).GetAsDouble());
-    PathPoint control2(ParsedPrimitiveHelper(inOperands[2]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[3]).GetAsDouble());
-    PathPoint to(ParsedPrimitiveHelper(inOperands[4]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[5]).GetAsDouble());
+    PathPoint control1(inOperands.GetNumber(0), inOperands.GetNumber(1));
+    PathPoint control2(inOperands.GetNumber(2), inOperands.GetNumber(3));
+    PathPoint to(inOperands.GetNumber(4), inOperands.GetNumber(5));
 
     return AppendComponentToCurrentPath(PathComponent(to, control1, control2));
 }
 
-bool GraphicContentInterpreter::vCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::vCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 4)
         return true; // too few params? ignore
 
     if(NoCurrentPoint())
         return true; // no current point, and its supposed to be used as a control point
 
-    PathPoint control1(currentPath.subPaths.back().components.back().to);
-    PathPoint control2(ParsedPrimitiveHelper(inOperands[0]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[1]).GetAsDouble());
-    PathPoint to(ParsedPrimitiveHelper(inOperands[2]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[3]).GetAsDouble());
+    PathPoint control1(currentPath.components.back().to);
+    PathPoint control2(inOperands.GetNumber(0), inOperands.GetNumber(1));
+    PathPoint to(inOperands.GetNumber(2), inOperands.GetNumber(3));
 
     return AppendComponentToCurrentPath(PathComponent(to, control1, control2));
 }
 
-bool GraphicContentInterpreter::yCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::yCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 4)
         return true; // too few params? ignore
 
-    PathPoint control1(ParsedPrimitiveHelper(inOperands[0]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[1]).GetAsDouble());
-    PathPoint control2(ParsedPrimitiveHelper(inOperands[2]).GetAsDouble(), ParsedPrimitiveHelper(inOperands[3]).GetAsDouble());
+    PathPoint control1(inOperands.GetNumber(0), inOperands.GetNumber(1));
+    PathPoint control2(inOperands.GetNumber(2), inOperands.GetNumber(3));
     PathPoint to(control2);
 
     return AppendComponentToCurrentPath(PathComponent(to, control1, control2));
@@ -615,50 +763,71 @@ bool GraphicContentInterpreter::CloseCurrentPath() {
     if(currentSubPath.isClosed)
         return true; // subpath already closed...so nothing more to do here
 
-    // explictly push the first point as last point and mark path as closed.
-    currentSubPath.components.push_back(PathComponent(*currentSubPath.components.begin()));
+    // explictly push the first point as last point and mark path as closed. (copy first, pushing may reallocate)
+    PathComponent firstComponent(currentPath.components[currentSubPath.firstComponent]);
+    currentPath.components.push_back(firstComponent);
+    ++currentSubPath.componentsCount;
     currentSubPath.isClosed = true;
 
     return true;
 }
 
 void GraphicContentInterpreter::CloseAllSubPaths() {
-    SubPathList::iterator it = currentPath.subPaths.begin();
+    // the last subpath can be closed by appending to the components. open subpaths before it need their closing
+    // point inserted in the middle, so if there are any, rebuild the components in one pass rather than inserting per subpath
+    bool hasOpenInnerSubPaths = false;
+    for(size_t i=0; i + 1 < currentPath.subPaths.size() && !hasOpenInnerSubPaths; ++i)
+        hasOpenInnerSubPaths = !currentPath.subPaths[i].isClosed;
+
+    if(!hasOpenInnerSubPaths) {
+        if(!NoCurrentPoint())
+            CloseCurrentPath();
+        return;
+    }
 
+    closingComponents.clear();
+    SubPathVector::iterator it = currentPath.subPaths.begin();
     for(; it != currentPath.subPaths.end(); ++it) {
-        SubPath& currentSubPath = *it;
+        PathComponentSpan components = currentPath.GetComponents(*it);
 
-        if(currentSubPath.isClosed)
+        it->firstComponent = closingComponents.size();
+        closingComponents.insert(closingComponents.end(), components.begin(), components.end());
+
+        if(it->isClosed)
             continue; // subpath already closed...so nothing more to do here
 
         // explictly push the first point as last point and mark path as closed.
-        currentSubPath.components.push_back(PathComponent(*currentSubPath.components.begin()));
-        currentSubPath.isClosed = true;
-
+        PathComponent firstComponent(closingComponents[it->firstComponent]);
+        closingComponents.push_back(firstComponent);
+        ++(it->componentsCount);
+        it->isClosed = true;
     }
+    currentPath.components.swap(closingComponents);
 } 
 
-bool GraphicContentInterpreter::hCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::hCommand(const ContentOperandStack& inOperands) {
     return CloseCurrentPath();
 }
 
-bool GraphicContentInterpreter::reCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::reCommand(const ContentOperandStack& inOperands) {
     if(inOperands.size() < 4)
         return true; // too few params? ignore
 
-    double x = ParsedPrimitiveHelper(inOperands[0]).GetAsDouble();
-    double y =  ParsedPrimitiveHelper(inOperands[1]).GetAsDouble();
-    double width = ParsedPrimitiveHelper(inOperands[2]).GetAsDouble();
-    double height =  ParsedPrimitiveHelper(inOperands[3]).GetAsDouble();
+    double x = inOperands.GetNumber(0);
+    double y =  inOperands.GetNumber(1);
+    double width = inOperands.GetNumber(2);
+    double height =  inOperands.GetNumber(3);
 
     SubPath newSubPath;
 
-    newSubPath.components.push_back(PathComponent(PathPoint(x,y))); // x y m
-    newSubPath.components.push_back(PathComponent(PathPoint(x+width,y))); // (x+width) y l
-    newSubPath.components.push_back(PathComponent(PathPoint(x+width,y+height))); // (x+width) (y+height) l
-    newSubPath.components.push_back(PathComponent(PathPoint(x,y+height))); // x (y+height) l
+    newSubPath.firstComponent = currentPath.components.size();
+    currentPath.components.push_back(PathComponent(PathPoint(x,y))); // x y m
+    currentPath.components.push_back(PathComponent(PathPoint(x+width,y))); // (x+width) y l
+    currentPath.components.push_back(PathComponent(PathPoint(x+width,y+height))); // (x+width) (y+height) l
+    currentPath.components.push_back(PathComponent(PathPoint(x,y+height))); // x (y+height) l
     // h
-    newSubPath.components.push_back(PathComponent(PathPoint(x,y)));
+    currentPath.components.push_back(PathComponent(PathPoint(x,y)));
+    newSubPath.componentsCount = 5;
     newSubPath.isClosed = true;
 
     currentPath.subPaths.push_back(newSubPath);
@@ -670,21 +839,25 @@ bool GraphicContentInterpreter::PaintCurrentPath(bool inShouldStroke, bool inSho
      if(NoCurrentPoint()) // no path, ignore
         return true;
 
-    PathElement pathElement = {
-        Path(currentPath),
-        ContentGraphicState(CurrentGraphicState()),
-        { currentColorRGB[0], currentColorRGB[1], currentColorRGB[2], },
+    PathElement pathElement(
+        Path(),
+        CurrentGraphicState(),
+        currentColorRGB,
         inShouldStroke,
         inShouldFill,
         inFillMethod
-    };
+    );
 
+    // lend the current path buffers to the element rather than copying them, and take them back (cleared) for the next path
+    pathElement.path.Swap(currentPath);
+    bool result = EmitPathElement(pathElement);
+    currentPath.Swap(pathElement.path);
     ClearCurrentPath();
 
-    return handler->OnPathPainted(pathElement);
+    return result;
 }
 
-bool GraphicContentInterpreter::SCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::SCommand(const ContentOperandStack& inOperands) {
     return PaintCurrentPath(
         true,
         false,
@@ -692,11 +865,11 @@ bool GraphicContentInterpreter::SCommand(const PDFObjectVector& inOperands) {
     );
 }
 
-bool GraphicContentInterpreter::sCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::sCommand(const ContentOperandStack& inOperands) {
     return CloseCurrentPath() && SCommand(inOperands);
 }
 
-bool GraphicContentInterpreter::fCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::fCommand(const ContentOperandStack& inOperands) {
     CloseAllSubPaths();
 
     return PaintCurrentPath(
@@ -706,7 +879,7 @@ bool GraphicContentInterpreter::fCommand(const PDFObjectVector& inOperands) {
     );
 }
 
-bool GraphicContentInterpreter::fStarCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::fStarCommand(const ContentOperandStack& inOperands) {
     return PaintCurrentPath(
         false,
         true,
@@ -714,7 +887,7 @@ bool GraphicContentInterpreter::fStarCommand(const PDFObjectVector& inOperands)
     );
 }
 
-bool GraphicContentInterpreter::BCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::BCommand(const ContentOperandStack& inOperands) {
     CloseAllSubPaths();
 
     return PaintCurrentPath(
@@ -724,7 +897,7 @@ bool GraphicContentInterpreter::BCommand(const PDFObjectVector& inOperands) {
     );
 }
 
-bool GraphicContentInterpreter::BStarCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::BStarCommand(const ContentOperandStack& inOperands) {
     return PaintCurrentPath(
         true,
         true,
@@ -732,33 +905,54 @@ bool GraphicContentInterpreter::BStarCommand(const PDFObjectVector& inOperands)
     );
 }
 
-bool GraphicContentInterpreter::bCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::bCommand(const ContentOperandStack& inOperands) {
     return CloseCurrentPath() && BCommand(inOperands);
 }
 
-bool GraphicContentInterpreter::bStarCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::bStarCommand(const ContentOperandStack& inOperands) {
     return CloseCurrentPath() && BStarCommand(inOperands);
 }
 
-bool GraphicContentInterpreter::nCommand(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::nCommand(const ContentOperandStack& inOperands) {
     ClearCurrentPath();
     return true;
 }
 
-bool GraphicContentInterpreter::setCurrentColor(const PDFObjectVector& inOperands) {
+bool GraphicContentInterpreter::setCurrentColor(const ContentOperandStack& inOperands) {
     if (inOperands.size() > 2) {
-        currentColorRGB[0] = ParsedPrimitiveHelper(inOperands[inOperands.size() - 3]).GetAsDouble();
-        currentColorRGB[1] = ParsedPrimitiveHelper(inOperands[inOperands.size() - 2]).GetAsDouble();
-        currentColorRGB[2] = ParsedPrimitiveHelper(inOperands[inOperands.size() - 1]).GetAsDouble();
+        currentColorRGB[0] = inOperands.GetNumber(inOperands.size() - 3);
+        currentColorRGB[1] = inOperands.GetNumber(inOperands.size() - 2);
+        currentColorRGB[2] = inOperands.GetNumber(inOperands.size() - 1);
     }
     return true;
 }
 
 bool GraphicContentInterpreter::OnResourcesRead(IInterpreterContext* inContext) {
-    resourcesStack.push_back(Resources()); // pushs on page start, and also on any drawn xobject start
+    Resources* resources;
+    ObjectIDType resourcesObjectID = inContext->GetResourcesObjectID();
+
+    if(resourcesObjectID != 0) {
+        ObjectIDTypeToResourcesMap::iterator it = sharedResources.find(resourcesObjectID);
+        if(it == sharedResources.end()) {
+            it = sharedResources.insert(ObjectIDTypeToResourcesMap::value_type(resourcesObjectID, Resources())).first;
+            ReadResources(inContext, it->second);
+        }
+        resources = &(it->second);
+    }
+    else {
+        contentResources.push_back(Resources());
+        ReadResources(inContext, contentResources.back());
+        resources = &(contentResources.back());
+    }
+
+    resourcesStack.push_back(resources); // pushs on page start, and also on any drawn xobject start
 
-    Resources& currentResources = resourcesStack.back();
+    if(!(interests & eGraphicContentInterestResources))
+        return true;
+    return handler->OnResourcesRead(*resources, inContext);
+}
 
+void GraphicContentInterpreter::ReadResources(IInterpreterContext* inContext, Resources& outResources) {
     // read extgstates for font references
     RefCountPtr<PDFDictionary> gstateCategoryDict = inContext->FindResourceCategory("ExtGState");
     if(!!gstateCategoryDict) {
@@ -767,29 +961,32 @@ bool GraphicContentInterpreter::OnResourcesRead(IInterpreterContext* inContext)
         while(it.MoveNext()) {
             PDFObject* gsInCat = it.GetValue();
 
-            PDFDictionary* gsAsDict;
+            PDFDictionary* gsAsDict = NULL;
             if(gsInCat->GetType() == PDFObject::ePDFObjectIndirectObjectReference) {
                 PDFObjectCastPtr<PDFDictionary> gsAsDictQ = inContext->GetParser()->ParseNewObject(((PDFIndirectObjectReference*)gsInCat)->mObjectID);
                 gsAsDict = gsAsDictQ.GetPtr();
-                gsAsDictQ->AddRef();
+                if(gsAsDict)
+                    gsAsDict->AddRef();
             }
             else if(gsInCat->GetType() == PDFObject::ePDFObjectDictionary) {
                 gsAsDict = (PDFDictionary*)gsInCat;
+                gsAsDict->AddRef(); // released when done, same as a parsed one
             }
 
             if(gsAsDict) {
-                // all i care about are font entries, so store it so i dont have to parse later (will cause trouble with interpretation)
+                // all i care about are font entries, so store it so i dont have to parse later (will cause trouble with interpretation).
+                // and when texts are recorded, their constant alpha, so that gs doesn't have to resolve the state again on each use
                 PDFObjectCastPtr<PDFArray> fontDesc = inContext->GetParser()->QueryDictionaryObject(gsAsDict, "Font");
                 RefCountPtr<PDFObject> lineWidthDesc = inContext->GetParser()->QueryDictionaryObject(gsAsDict, "LW");
 
-                if(!!fontDesc || !!lineWidthDesc) {
+                if(!!fontDesc || !!lineWidthDesc || shouldRecordTexts) {
                     GSState gState;
 
                     if(!!fontDesc) {
                         RefCountPtr<PDFObject> fontRef = fontDesc->QueryObject(0);
                         RefCountPtr<PDFObject> size = fontDesc->QueryObject(1);
                         double fontSize = ParsedPrimitiveHelper(size.GetPtr()).GetAsDouble();
-                        gState.fontRef = fontRef;
+                        gState.fontRef = !fontRef ? NULL : AddFont(fontRef.GetPtr());
                         gState.fontSize = fontSize;
                         gState.hasFont = true;
                     }
@@ -800,7 +997,10 @@ bool GraphicContentInterpreter::OnResourcesRead(IInterpreterContext* inContext)
                         gState.hasLineWidth = true;
                     }
 
-                    currentResources.gStates.insert(StringToGStateMap::value_type(it.GetKey()->GetValue(), gState));
+                    if(shouldRecordTexts)
+                        gState.constantAlpha = inContext->GetParser()->GetConstantAplha(it.GetKey()->GetValue());
+
+                    outResources.gStates.insert(StringToGStateMap::value_type(it.GetKey()->GetValue(), gState));
                 }
 
                 gsAsDict->Release();
@@ -814,14 +1014,246 @@ bool GraphicContentInterpreter::OnResourcesRead(IInterpreterContext* inContext)
         MapIterator<PDFNameToPDFObjectMap> it = fontCategoryDict->GetIterator();
 
         while(it.MoveNext()) {
-            RefCountPtr<PDFObject> fontRef;
-            fontRef = it.GetValue();
+            Font font(AddFont(it.GetValue()));
+
+            if(shouldRecordTexts) {
+                // style goes by the font base name. figured out here once, rather than on every Tf
+                string baseFont = inContext->GetParser()->GetBaseFontName(it.GetKey());
+                font.isBold = baseFont.find("Bold") != string::npos || baseFont.find("bold") != string::npos;
+                font.isItalic = baseFont.find("Italic") != string::npos || baseFont.find("italic") != string::npos;
+            }
 
-            currentResources.fonts.insert(StringToFontMap::value_type(it.GetKey()->GetValue(), Font(fontRef)));
+            outResources.fonts.insert(StringToFontMap::value_type(it.GetKey()->GetValue(), font));
         }
     }    
+}
+
+PDFObject* GraphicContentInterpreter::AddFont(PDFObject* inFontRef) {
+    // font references of the same font object are all the same font, so keep the first one
+    ObjectIDType fontObjectID = 0;
+    if(inFontRef->GetType() == PDFObject::ePDFObjectIndirectObjectReference) {
+        fontObjectID = ((PDFIndirectObjectReference*)inFontRef)->mObjectID;
+        ObjectIDTypeToPDFObjectMap::iterator it = fontsByObjectID.find(fontObjectID);
+        if(it != fontsByObjectID.end())
+            return it->second;
+        fontsByObjectID.insert(ObjectIDTypeToPDFObjectMap::value_type(fontObjectID, inFontRef));
+    }
+
+    inFontRef->AddRef(); // the table holds a reference of its own
+    fonts.push_back(RefCountPtr<PDFObject>(inFontRef));
+    return inFontRef;
+}
+
+bool GraphicContentInterpreter::IsRecordingForm() {
+    FormPlacementList::iterator it = formPlacementsStack.begin();
+    for(; it != formPlacementsStack.end(); ++it) {
+        if(!!it->recordedResult)
+            return true;
+    }
+    return false;
+}
+
+void GraphicContentInterpreter::RecordFormsTextElement(const TextElement& inTextElement, const TextParameters& inParameters) {
+    // add to the results of forms being recorded, in their form space
+    FormPlacementList::iterator it = formPlacementsStack.begin();
+    for(; it != formPlacementsStack.end(); ++it) {
+        if(!it->recordedResult)
+            continue;
+
+        FormResultItem item;
+        item.isText = true;
+        item.textElement = inTextElement;
+        item.textParameters = inParameters;
+        TransformStates(item.textElement, it->inverseCtm);
+        it->recordedResult->items.push_back(item);
+    }
+}
+
+bool GraphicContentInterpreter::EmitTextElement(const TextElement& inTextElement, const TextParameters& inParameters) {
+    RecordFormsTextElement(inTextElement, inParameters);
+
+    if(shouldStreamTexts) {
+        // a replayed element. stream its commands
+        bool shouldContinue = true;
+        isTextElementStart = true;
+        hasTextRun = false;
+
+        PlacedTextCommandList::const_iterator it = inTextElement.texts.begin();
+        for(; it != inTextElement.texts.end() && shouldContinue; ++it)
+            shouldContinue = EmitTextCommand(it->text, it->graphicState, it->textState, inParameters);
+        return shouldContinue;
+    }
+
+    // culled after recording, as forms results may be replayed in other pages (with other regions)
+    if(!!regions && !IsInRegions(inTextElement))
+        return true;
+
+    return handler->OnTextElementComplete(inTextElement, inParameters);
+}
+
+bool GraphicContentInterpreter::EmitTextCommand(
+    const PlacedTextCommandArgumentList& inText,
+    const ContentGraphicState& inGraphicState,
+    const TextGraphicState& inTextState,
+    const TextParameters& inParameters) {
+    if(!!regions) {
+        // like with whole elements, go by where texts start. commands that set the position start a new run, and the
+        // commands continuing it go with it
+        if(!hasTextRun || inTextState.tmDirty) {
+            isTextRunInRegions = IsInRegions(inGraphicState, inTextState);
+            hasTextRun = true;
+        }
+        if(!isTextRunInRegions)
+            return true;
+    }
+
+    PlacedTextCommandRef command = {inText, inGraphicState, inTextState, isTextElementStart};
+    isTextElementStart = false;
+    return handler->OnTextCommand(command, inParameters);
+}
+
+bool GraphicContentInterpreter::EmitPathElement(const PathElement& inPathElement) {
+    FormPlacementList::iterator it = formPlacementsStack.begin();
+    for(; it != formPlacementsStack.end(); ++it) {
+        if(!it->recordedResult)
+            continue;
+
+        FormResultItem item;
+        item.isText = false;
+        item.pathElement = inPathElement;
+        TransformStates(item.pathElement, it->inverseCtm);
+        it->recordedResult->items.push_back(item);
+    }
+
+    if(!!regions && !IsInRegions(inPathElement))
+        return true;
+
+    return handler->OnPathPainted(inPathElement);
+}
 
-    return handler->OnResourcesRead(currentResources, inContext);
+bool GraphicContentInterpreter::IsInRegions(const ContentGraphicState& inGraphicState, const TextGraphicState& inTextState) {
+    // the text origin, in page space
+    double origin[2] = {0, 0};
+    double matrix[6];
+    double pageOrigin[2];
+
+    MultiplyMatrix(inTextState.tm, inGraphicState.ctm, matrix);
+    TransformVector(origin, matrix, pageOrigin);
+    return IsPointWithinRegions(pageOrigin, *regions);
+}
+
+bool GraphicContentInterpreter::IsInRegions(const TextElement& inTextElement) {
+    // text widths are only known once decoded with the font, which is what culling should save. so go by where texts
+    // start - the origins of the element texts that are explicitly positioned (the others continue the texts before them).
+    // an element is in if any of those origins is within the regions
+    bool hasPosition = false;
+
+    PlacedTextCommandList::const_iterator it = inTextElement.texts.begin();
+    for(; it != inTextElement.texts.end(); ++it) {
+        if(hasPosition && !it->textState.tmDirty)
+            continue;
+        hasPosition = true;
+
+        if(IsInRegions(it->graphicState, it->textState))
+            return true;
+    }
+
+    return false;
+}
+
+bool GraphicContentInterpreter::IsInRegions(const PathElement& inPathElement) {
+    // bounding box of the path points (control points included, which can only make it larger), in page space
+    bool hasPoints = false;
+    double box[4] = {0, 0, 0, 0};
+
+    // all subpaths components are in the one vector, so just go over it
+    PathComponentVector::const_iterator it = inPathElement.path.components.begin();
+    for(; it != inPathElement.path.components.end(); ++it) {
+        const PathPoint* points[3] = {&(it->to), &(it->control1), &(it->control2)};
+        int pointsCount = it->isCubicBezier ? 3 : 1;
+        for(int i=0; i < pointsCount; ++i) {
+            if(!hasPoints) {
+                box[0] = box[2] = points[i]->x;
+                box[1] = box[3] = points[i]->y;
+                hasPoints = true;
+                continue;
+            }
+            box[0] = min(box[0], points[i]->x);
+            box[1] = min(box[1], points[i]->y);
+            box[2] = max(box[2], points[i]->x);
+            box[3] = max(box[3], points[i]->y);
+        }
+    }
+
+    if(!hasPoints)
+        return false;
+
+    double pageBox[4];
+    TransformBox(box, inPathElement.graphicState.ctm, pageBox);
+    return DoesBoxIntersectRegions(pageBox, *regions);
+}
+
+bool GraphicContentInterpreter::IsFormEntryState(const FormResult& inResult) {
+    const ContentGraphicState& graphicState = CurrentGraphicState();
+    const TextGraphicState& textState = graphicState.textGraphicState;
+    const TextGraphicState& resultTextState = inResult.textState;
+
+    return graphicState.lineWidth == inResult.lineWidth &&
+            currentColorRGB[0] == inResult.colorRGB[0] &&
+            currentColorRGB[1] == inResult.colorRGB[1] &&
+            currentColorRGB[2] == inResult.colorRGB[2] &&
+            textState.charSpace == resultTextState.charSpace &&
+            textState.wordSpace == resultTextState.wordSpace &&
+            textState.scale == resultTextState.scale &&
+            textState.leading == resultTextState.leading &&
+            textState.rise == resultTextState.rise &&
+            textState.fontSize == resultTextState.fontSize &&
+            textState.tmDirty == resultTextState.tmDirty &&
+            textState.tlmDirty == resultTextState.tlmDirty &&
+            IsSameMatrix(textState.tm, resultTextState.tm) &&
+            IsSameMatrix(textState.tlm, resultTextState.tlm) &&
+            textState.fontRef == resultTextState.fontRef; // same font, same table entry
+}
+
+FormResult* GraphicContentInterpreter::GetFormResult(ObjectIDType inFormObjectID) {
+    FormResultList& results = formResults[inFormObjectID];
+
+    FormResultList::iterator it = results.begin();
+    for(; it != results.end(); ++it) {
+        if(IsFormEntryState(*it))
+            return &(*it);
+    }
+
+    // first placement with this state
+    results.push_back(FormResult());
+    FormResult& result = results.back();
+    result.textState = CurrentGraphicState().textGraphicState;
+    result.lineWidth = CurrentGraphicState().lineWidth;
+    CopyVector(currentColorRGB, result.colorRGB);
+    return &result;
+}
+
+void GraphicContentInterpreter::ReplayFormResult(const FormResult& inResult, const double (&inPlacementCtm)[6]) {
+    FormResultItemList::const_iterator it = inResult.items.begin();
+    bool shouldContinue = true;
+
+    for(; it != inResult.items.end() && shouldContinue; ++it) {
+        if(it->isText) {
+            TextElement textElement(it->textElement);
+            TransformStates(textElement, inPlacementCtm);
+            shouldContinue = EmitTextElement(textElement, it->textParameters);
+        }
+        else {
+            PathElement pathElement(it->pathElement);
+            TransformStates(pathElement, inPlacementCtm);
+            shouldContinue = EmitPathElement(pathElement);
+        }
+    }
+
+    CopyVector(inResult.exitColorRGB, currentColorRGB);
+
+    if(!shouldContinue)
+        stopRequested = true;
 }
 
 bool GraphicContentInterpreter::OnXObjectDoStart(
@@ -829,10 +1261,36 @@ bool GraphicContentInterpreter::OnXObjectDoStart(
         ObjectIDType inXObjectObjectID,
         PDFStreamInput* inXObject,
         PDFParser* inParser) {
+    FormPlacement placement;
+    placement.recordedResult = NULL;
+    placement.resourcesDepth = resourcesStack.size();
+
+    // results are only good for forms placed outside of text elements and path construction, which a form
+    // could otherwise continue
+    FormResult* result = NULL;
+    double placementCtm[6];
+    CopyMatrix(CurrentGraphicState().ctm, placementCtm);
+    if(!isInTextElement && NoCurrentPoint() && InverseMatrix(placementCtm, placement.inverseCtm)) {
+        result = GetFormResult(inXObjectObjectID);
+        ++(result->placementsCount);
+    }
+
     // the equivalent of q, so any internal transformations do not effect the outside. specifically what im gonna
     // do now to emulate form placement matrix changes
     PushGraphicState();
 
+    if(!!result && result->isReady) {
+        // seen this before, replay instead of interpreting the form again
+        formPlacementsStack.push_back(placement);
+        ReplayFormResult(*result, placementCtm);
+        return false;
+    }
+
+    // record on the second placement, so forms used once don't get recorded for nothing
+    if(!!result && result->isCacheable && result->placementsCount > 1)
+        placement.recordedResult = result;
+    formPlacementsStack.push_back(placement);
+
     // apply form matrix
     RefCountPtr<PDFDictionary> formDict = inXObject->QueryStreamDictionary();
     PDFObjectCastPtr<PDFArray> formMatrix = inParser->QueryDictionaryObject(formDict.GetPtr(), "Matrix");
@@ -855,8 +1313,29 @@ void GraphicContentInterpreter::OnXObjectDoEnd(
     PDFStreamInput* inXObject,
     PDFParser* inParser) {
 
-    // pop resources stack (was placed on resources read, which comes right when you start reading the form)
-    resourcesStack.pop_back();        
+    if(formPlacementsStack.size() > 0) {
+        FormPlacement& placement = formPlacementsStack.back();
+        FormResult* result = placement.recordedResult;
+
+        if(!!result) {
+            if(isInTextElement || !NoCurrentPoint()) {
+                // form left an open text element or an unpainted path for the content after it. replaying would miss that, so don't
+                result->items.clear();
+                result->isCacheable = false;
+            }
+            else {
+                CopyVector(currentColorRGB, result->exitColorRGB);
+                result->isReady = true;
+                formResultsReadyInPage.push_back(result);
+            }
+        }
+
+        // pop resources stack (was placed on resources read, which comes right when you start reading the form. replayed
+        // forms are not read, so there's nothing to pop for them)
+        while(resourcesStack.size() > placement.resourcesDepth)
+            resourcesStack.pop_back();
+        formPlacementsStack.pop_back();
+    }
 
     // the equivalent of Q removing all artifacts of the form state changes
     PopGraphicState();
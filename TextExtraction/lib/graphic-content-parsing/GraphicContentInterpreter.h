@@ -9,18 +9,43 @@
 #include "TextElement.h"
 #include "Path.h"
 #include "PathElement.h"
+#include "FormResult.h"
+#include "RegionsOfInterest.h"
 
 #include "../text-parsing/ParsedTextPlacement.h"
 
+#include "RefCountPtr.h"
+
 #include <list>
 #include <map>
+#include <vector>
 
-typedef std::list<TextGraphicState> TextGraphicStateList;
-typedef std::list<ContentGraphicState> GraphicStateList;
+typedef std::vector<TextGraphicState> TextGraphicStateVector;
+typedef std::vector<ContentGraphicState> GraphicStateVector;
 typedef std::list<Resources> ResourcesList;
+typedef std::vector<Resources*> ResourcesPtrVector;
+typedef std::map<ObjectIDType, Resources> ObjectIDTypeToResourcesMap;
+typedef std::vector<RefCountPtr<PDFObject> > PDFObjectRefVector;
+typedef std::map<ObjectIDType, PDFObject*> ObjectIDTypeToPDFObjectMap;
+
+// FormPlacement is the state of a form being drawn
+struct FormPlacement {
+    // the result being recorded for the form, if any
+    FormResult* recordedResult;
+    // for converting the form output to form space
+    double inverseCtm[6];
+    size_t resourcesDepth;
+};
+
+typedef std::list<FormPlacement> FormPlacementList;
+typedef std::list<FormResult*> FormResultPtrList;
 
+class CancellationToken;
+class ContentPrefetcher;
 
-class GraphicContentInterpreter: public IPDFRecursiveInterpreterHandler {
+
+// final, so the recursive interpreter calls it directly (see PDFRecursiveInterpreterT)
+class GraphicContentInterpreter final: public IPDFRecursiveInterpreterHandler {
 public:
     GraphicContentInterpreter(void);
     virtual ~GraphicContentInterpreter(void);
@@ -31,8 +56,18 @@ public:
         PDFDictionary* inPage,
         IGraphicContentInterpreterHandler* inHandler);
 
+    // stop interpretation (between operators) once the token is cancelled or expired
+    void SetCancellationToken(const CancellationToken* inCancellationToken);
+
+    // read content streams decoded ahead by the prefetcher, when they are
+    void SetContentPrefetcher(ContentPrefetcher* inContentPrefetcher);
+
+    // limit the next interpreted pages to regions. text elements and paths outside of all regions are not passed on
+    // to the handler. regions are not owned, and should live as long as they're set. pass NULL for whole pages
+    void SetRegions(const RegionBoxList* inRegions);
+
     // IPDFRecursiveInterpreterHandler implementation
-    virtual bool OnOperation(const std::string& inOperation,  const PDFObjectVector& inOperands, IInterpreterContext* inContext);
+    virtual bool OnOperation(EContentOperator inOperator, const std::string& inOperation,  const ContentOperandStack& inOperands, IInterpreterContext* inContext);
 
     virtual bool OnResourcesRead(IInterpreterContext* inContext);
     virtual bool OnXObjectDoStart(
@@ -48,60 +83,123 @@ public:
         PDFParser* inParser);        
 
 private:
-    ResourcesList resourcesStack;
-    GraphicStateList graphicStateStack;
-    TextGraphicStateList textGraphicStateStack;
+    // stacks are vectors of plain data, kept between pages, so that pushing and popping (q/Q) is copying with no allocations
+    ResourcesPtrVector resourcesStack;
+    // resources are read once per resources dictionary object, and shared between pages and forms using it.
+    // direct resources dictionaries only go for the content holding them, so those are kept per page
+    ObjectIDTypeToResourcesMap sharedResources;
+    ResourcesList contentResources;
+    GraphicStateVector graphicStateStack;
+    TextGraphicStateVector textGraphicStateStack;
+    // reused for path after path. painting lends its buffers to the painted path element
     Path currentPath;
+    // scratch for closing all subpaths, kept so it doesn't allocate per path
+    PathComponentVector closingComponents;
     double currentColorRGB[3] = {};
 
     bool isInTextElement;
+    // commands of the current text element. when streaming texts they're only kept if a form being recorded needs them
+    bool isBufferingTextElement;
     PlacedTextCommandList currentTextElementCommands;
+    // streamed text element state. whether the handler got a command of the element yet, and whether the run of commands
+    // positioned together that is being streamed is within the regions
+    bool isTextElementStart;
+    bool hasTextRun;
+    bool isTextRunInRegions;
 
     IGraphicContentInterpreterHandler* handler;
+    const CancellationToken* cancellationToken;
+    ContentPrefetcher* contentPrefetcher;
+    const RegionBoxList* regions;
+    bool stopRequested;
+
+    // handler interests, and so what to build
+    unsigned int interests;
+    bool shouldRecordTexts;
+    bool shouldStreamTexts;
+    bool shouldBuildPaths;
+    bool shouldTrackColors;
+
+    // shared resources and forms results are kept between pages, as long as the parser (and handler interests) is the same
+    PDFParser* cachedResultsParser;
+    unsigned int cachedResultsInterests;
+
+    // forms results, per form object and entry state. forms placed repeatedly (logos, watermarks and such)
+    // are recorded on their second placement and replayed on any later placement instead of being interpreted again.
+    ObjectIDTypeToFormResultListMap formResults;
+
+    // fonts table. resources and text states refer to fonts by plain pointers to the font objects held here, so
+    // that graphic states don't own anything. fonts of the same object are held once. kept as long as resources
+    // and forms results are
+    PDFObjectRefVector fonts;
+    ObjectIDTypeToPDFObjectMap fontsByObjectID;
+    FormResultPtrList formResultsReadyInPage;
+    FormPlacementList formPlacementsStack;
 
     void InitInterpretationState();
     void ResetInterpretationState();
 
+    void ReadResources(IInterpreterContext* inContext, Resources& outResources);
+    PDFObject* AddFont(PDFObject* inFontRef);
+
+    FormResult* GetFormResult(ObjectIDType inFormObjectID);
+    bool IsFormEntryState(const FormResult& inResult);
+    void ReplayFormResult(const FormResult& inResult, const double (&inPlacementCtm)[6]);
+    bool IsRecordingForm();
+    void RecordFormsTextElement(const TextElement& inTextElement, const TextParameters& inParameters);
+    bool EmitTextElement(const TextElement& inTextElement, const TextParameters& inParameters);
+    bool EmitTextCommand(
+        const PlacedTextCommandArgumentList& inText,
+        const ContentGraphicState& inGraphicState,
+        const TextGraphicState& inTextState,
+        const TextParameters& inParameters);
+    bool EmitPathElement(const PathElement& inPathElement);
+    bool IsInRegions(const ContentGraphicState& inGraphicState, const TextGraphicState& inTextState);
+    bool IsInRegions(const TextElement& inTextElement);
+    bool IsInRegions(const PathElement& inPathElement);
+
+
+    bool OnPathOperation(EContentOperator inOperator, const ContentOperandStack& inOperands);
 
     // interpreted commands
     bool qCommand();
     bool QCommand();
-    bool cmCommand(const PDFObjectVector& inOperands);
-    bool wCommand(const PDFObjectVector& inOperands);
-    bool gsCommand(const PDFObjectVector& inOperands, IInterpreterContext* inContext);
-    bool TcCommand(const PDFObjectVector& inOperands);
-    bool TwCommand(const PDFObjectVector& inOperands);
-    bool TzCommand(const PDFObjectVector& inOperands);
-    bool TLCommand(const PDFObjectVector& inOperands);
-    bool TsCommand(const PDFObjectVector& inOperands);
-    bool TfCommand(const PDFObjectVector& inOperands, IInterpreterContext* inContext);
+    bool cmCommand(const ContentOperandStack& inOperands);
+    bool wCommand(const ContentOperandStack& inOperands);
+    bool gsCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext);
+    bool TcCommand(const ContentOperandStack& inOperands);
+    bool TwCommand(const ContentOperandStack& inOperands);
+    bool TzCommand(const ContentOperandStack& inOperands);
+    bool TLCommand(const ContentOperandStack& inOperands);
+    bool TsCommand(const ContentOperandStack& inOperands);
+    bool TfCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext);
     bool BTCommand();
     bool ETCommand(IInterpreterContext* inContext);
-    bool TdCommand(const PDFObjectVector& inOperands);
-    bool TDCommand(const PDFObjectVector& inOperands);
-    bool TmCommand(const PDFObjectVector& inOperands);
+    bool TdCommand(const ContentOperandStack& inOperands);
+    bool TDCommand(const ContentOperandStack& inOperands);
+    bool TmCommand(const ContentOperandStack& inOperands);
     bool TStarCommand();
-    bool TjCommand(const PDFObjectVector& inOperands);
-    bool QuoteCommand(const PDFObjectVector& inOperands);
-    bool DoubleQuoteCommand(const PDFObjectVector& inOperands);
-    bool TJCommand(const PDFObjectVector& inOperands);
-    bool mCommand(const PDFObjectVector& inOperands);
-    bool lCommand(const PDFObjectVector& inOperands);
-    bool cCommand(const PDFObjectVector& inOperands);
-    bool vCommand(const PDFObjectVector& inOperands);
-    bool yCommand(const PDFObjectVector& inOperands);
-    bool hCommand(const PDFObjectVector& inOperands);
-    bool reCommand(const PDFObjectVector& inOperands);
-    bool SCommand(const PDFObjectVector& inOperands);
-    bool sCommand(const PDFObjectVector& inOperands);
-    bool fCommand(const PDFObjectVector& inOperands);
-    bool fStarCommand(const PDFObjectVector& inOperands);
-    bool BCommand(const PDFObjectVector& inOperands);
-    bool BStarCommand(const PDFObjectVector& inOperands);
-    bool bCommand(const PDFObjectVector& inOperands);
-    bool bStarCommand(const PDFObjectVector& inOperands);
-    bool nCommand(const PDFObjectVector& inOperands);
-    bool setCurrentColor(const PDFObjectVector& inOperands);
+    bool TjCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext);
+    bool QuoteCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext);
+    bool DoubleQuoteCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext);
+    bool TJCommand(const ContentOperandStack& inOperands, IInterpreterContext* inContext);
+    bool mCommand(const ContentOperandStack& inOperands);
+    bool lCommand(const ContentOperandStack& inOperands);
+    bool cCommand(const ContentOperandStack& inOperands);
+    bool vCommand(const ContentOperandStack& inOperands);
+    bool yCommand(const ContentOperandStack& inOperands);
+    bool hCommand(const ContentOperandStack& inOperands);
+    bool reCommand(const ContentOperandStack& inOperands);
+    bool SCommand(const ContentOperandStack& inOperands);
+    bool sCommand(const ContentOperandStack& inOperands);
+    bool fCommand(const ContentOperandStack& inOperands);
+    bool fStarCommand(const ContentOperandStack& inOperands);
+    bool BCommand(const ContentOperandStack& inOperands);
+    bool BStarCommand(const ContentOperandStack& inOperands);
+    bool bCommand(const ContentOperandStack& inOperands);
+    bool bStarCommand(const ContentOperandStack& inOperands);
+    bool nCommand(const ContentOperandStack& inOperands);
+    bool setCurrentColor(const ContentOperandStack& inOperands);
 
     void PushGraphicState();
     void PopGraphicState();
@@ -123,13 +221,13 @@ private:
     void Td(double inX, double inY);
     void setTm(const double (&matrix)[6]);
     void TStar();
-    void Quote(PDFObject* inObject);
+    bool Quote(const ContentOperandStack& inOperands, const ContentOperand& inText, IInterpreterContext* inContext);
 
     void StartTextElement();
     bool EndTextElement(IInterpreterContext* inContext);
 
-    void RecordTextPlacement(const PlacedTextCommandArgument& inTextPlacementOperation);
-    void RecordTextPlacement(const PlacedTextCommandArgumentList& inTextPlacementOperations);
+    bool RecordTextPlacement(const PlacedTextCommandArgument& inTextPlacementOperation, IInterpreterContext* inContext);
+    bool RecordTextPlacement(const PlacedTextCommandArgumentList& inTextPlacementOperations, IInterpreterContext* inContext);
 
     bool PaintCurrentPath(bool inShouldStroke, bool inShouldFill, EFillMethod inFillMethod);
 };
@@ -8,6 +8,26 @@
 
 class IInterpreterContext;
 
+// families of events a handler may be interested in. the interpreter only builds the state
+// needed for what the handler is interested in
+enum EGraphicContentInterest {
+    // OnTextElementComplete
+    eGraphicContentInterestText = 1,
+    // OnPathPainted
+    eGraphicContentInterestPaths = 2,
+    // PathElement colors. only relevant with paths
+    eGraphicContentInterestColors = 4,
+    // OnResourcesRead
+    eGraphicContentInterestResources = 8,
+
+    eGraphicContentInterestAll = 15,
+
+    // OnTextCommand, instead of OnTextElementComplete. texts are passed per text placement command (Tj, TJ, ' and ")
+    // as they're interpreted, rather than buffering whole text elements, which for content with a page long text element
+    // means buffering the whole page texts
+    eGraphicContentInterestTextCommands = 16
+};
+
 class IGraphicContentInterpreterHandler 
 {
 public:
@@ -15,6 +35,10 @@ public:
     // called for each text element on finish with the collected text element
     virtual bool OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters = TextParameters()) = 0;
 
+    // called for each text placement command when interested in text commands. when limited to regions, commands are culled per run
+    // of commands positioned together (from a command that sets the position till the next one)
+    virtual bool OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters = TextParameters()){return true;}
+
     // called for each path on finish with the collected path and respective drawing verb
     virtual bool OnPathPainted(const PathElement& inPathElement) = 0;
 
@@ -27,4 +51,9 @@ public:
     // any additional data per the underlying font object pointer.
     virtual bool OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext){return true;}
 
+    // which events to get, as EGraphicContentInterest flags. asked once per interpreted page.
+    // events not asked for won't be called, and the state building them is skipped (e.g. no paths are built
+    // for a handler that isn't interested in paths)
+    virtual unsigned int GetInterests() {return eGraphicContentInterestAll;}
+
 };
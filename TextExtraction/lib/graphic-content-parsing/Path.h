@@ -1,6 +1,7 @@
 #pragma once
 
-#include <list>
+#include <vector>
+#include <stddef.h>
 
 struct PathPoint {
     PathPoint() {
@@ -48,24 +49,39 @@ struct PathComponent {
 };
 
 
-typedef std::list<PathComponent> PathComponentList;
+typedef std::vector<PathComponent> PathComponentVector;
 
+// a subpath is a range of the path components
 struct SubPath {
-    SubPath():components() {
+    SubPath() {
+        firstComponent = 0;
+        componentsCount = 0;
         isClosed = false;
     }
 
-    SubPath(const SubPath& inOther):components(inOther.components) {
-        isClosed = inOther.isClosed;
-    }
-
-
-    PathComponentList components;
+    size_t firstComponent;
+    size_t componentsCount;
     bool isClosed;
 };
 
+typedef std::vector<SubPath> SubPathVector;
 
-typedef std::list<SubPath> SubPathList;
+// a view on the components of a subpath
+struct PathComponentSpan {
+    PathComponentSpan(const PathComponent* inData, size_t inSize) {
+        data = inData;
+        size = inSize;
+    }
+
+    const PathComponent* begin() const {return data;}
+    const PathComponent* end() const {return data + size;}
+    const PathComponent& front() const {return data[0];}
+    const PathComponent& back() const {return data[size-1];}
+    const PathComponent& operator[](size_t inIndex) const {return data[inIndex];}
+
+    const PathComponent* data;
+    size_t size;
+};
 
 /**
  *  A bit about how paths and subpaths and current point n such are expected to work in this representation.
@@ -82,14 +98,26 @@ typedef std::list<SubPath> SubPathList;
  * 
  * Implementing path/subpath relationship this way makes each subpath easy to understand independently with no ambiguity as to what
  * the first point might mean.
+ *
+ * Storage is flat - all components of all subpaths are in a single vector, in order, and subpaths are ranges of it. Clearing keeps
+ * the vectors capacity, so a path object can be reused for path after path without allocating.
  */
 
 struct Path {
-    Path():subPaths() {
+    void Clear() {
+        components.clear();
+        subPaths.clear();
     }
 
-    Path(const Path& inOther):subPaths(inOther.subPaths) {
+    void Swap(Path& ioOther) {
+        components.swap(ioOther.components);
+        subPaths.swap(ioOther.subPaths);
     }
 
-    SubPathList subPaths;
-};
\ No newline at end of file
+    PathComponentSpan GetComponents(const SubPath& inSubPath) const {
+        return PathComponentSpan(components.data() + inSubPath.firstComponent, inSubPath.componentsCount);
+    }
+
+    PathComponentVector components;
+    SubPathVector subPaths;
+};
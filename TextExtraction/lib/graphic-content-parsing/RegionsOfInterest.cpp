@@ -0,0 +1,73 @@
+#include "RegionsOfInterest.h"
+
+#include "../math/Transformations.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+
+static RegionBox NormalizedRegion(const double (&inBox)[4]) {
+    // allow for boxes given by any two opposite corners
+    RegionBox region;
+    region.box[0] = min(inBox[0], inBox[2]);
+    region.box[1] = min(inBox[1], inBox[3]);
+    region.box[2] = max(inBox[0], inBox[2]);
+    region.box[3] = max(inBox[1], inBox[3]);
+    return region;
+}
+
+void RegionsOfInterest::AddRegion(const double (&inBox)[4]) {
+    allPagesRegions.push_back(NormalizedRegion(inBox));
+}
+
+void RegionsOfInterest::AddRegion(unsigned long inPageIndex, const double (&inBox)[4]) {
+    pagesRegions[inPageIndex].push_back(NormalizedRegion(inBox));
+}
+
+void RegionsOfInterest::Clear() {
+    allPagesRegions.clear();
+    pagesRegions.clear();
+}
+
+bool RegionsOfInterest::IsEmpty() const {
+    return allPagesRegions.empty() && pagesRegions.empty();
+}
+
+const RegionBoxList* RegionsOfInterest::GetPageRegions(unsigned long inPageIndex) const {
+    PageIndexToRegionBoxListMap::const_iterator it = pagesRegions.find(inPageIndex);
+    if(it != pagesRegions.end())
+        return &(it->second);
+
+    return allPagesRegions.empty() ? NULL : &allPagesRegions;
+}
+
+bool DoesBoxIntersectRegions(const double (&inBox)[4], const RegionBoxList& inRegions) {
+    RegionBoxList::const_iterator it = inRegions.begin();
+    for(; it != inRegions.end(); ++it) {
+        if(DoBoxesIntersect(inBox, it->box))
+            return true;
+    }
+    return false;
+}
+
+bool IsPointWithinRegions(const double (&inPoint)[2], const RegionBoxList& inRegions) {
+    RegionBoxList::const_iterator it = inRegions.begin();
+    for(; it != inRegions.end(); ++it) {
+        if(isPointWithinBox(inPoint, it->box))
+            return true;
+    }
+    return false;
+}
+
+string RegionsToString(const RegionBoxList& inRegions) {
+    // the string is part of cache keys, so coordinates are written in full. a rounded one would let nearby regions share results
+    stringstream stream;
+    stream << setprecision(numeric_limits<double>::max_digits10);
+    RegionBoxList::const_iterator it = inRegions.begin();
+    for(; it != inRegions.end(); ++it)
+        stream << "[" << it->box[0] << " " << it->box[1] << " " << it->box[2] << " " << it->box[3] << "]";
+    return stream.str();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+
+// RegionBox is a rectangle of interest in a page, in page coordinates - [left, bottom, right, top]
+struct RegionBox {
+    double box[4];
+};
+
+typedef std::list<RegionBox> RegionBoxList;
+typedef std::map<unsigned long, RegionBoxList> PageIndexToRegionBoxListMap;
+
+/**
+ * RegionsOfInterest limits extraction to parts of pages (an invoice header, a form field area, a drawing title block).
+ * Regions are either per page index, or for all pages that don't have their own. Pages with no regions are extracted whole.
+ * The graphic content interpreter drops text elements and paths outside of a page regions before handing them to
+ * the handler, so no font decoding or line parsing happens for them, and extractions keep only placements
+ * intersecting the regions.
+ **/
+class RegionsOfInterest {
+    public:
+        // add a region for all pages
+        void AddRegion(const double (&inBox)[4]);
+        // add a region for a particular page
+        void AddRegion(unsigned long inPageIndex, const double (&inBox)[4]);
+        void Clear();
+
+        bool IsEmpty() const;
+        // regions of a page, or NULL if the page is to be extracted whole
+        const RegionBoxList* GetPageRegions(unsigned long inPageIndex) const;
+
+    private:
+        RegionBoxList allPagesRegions;
+        PageIndexToRegionBoxListMap pagesRegions;
+};
+
+bool DoesBoxIntersectRegions(const double (&inBox)[4], const RegionBoxList& inRegions);
+bool IsPointWithinRegions(const double (&inPoint)[2], const RegionBoxList& inRegions);
+// regions as text, for telling apart results of the same page computed for different regions (e.g. in cache keys)
+std::string RegionsToString(const RegionBoxList& inRegions);
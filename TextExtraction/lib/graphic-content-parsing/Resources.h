@@ -1,24 +1,33 @@
 #pragma once
 
-#include "RefCountPtr.h"
 #include "PDFObject.h"
 
 #include <map>
+#include <string>
+
+// font references (fontRef) here and in text states are font objects from the fonts table of the interpreter that
+// read the resources. the table owns them, and keeps them for as long as it keeps its resources and forms results,
+// so hold on to them (AddRef) if they're needed past that
 
 struct GSState {
     GSState() {
         hasFont = false;
+        fontRef = NULL;
         hasLineWidth = false;
+        constantAlpha = 1;
     }
 
     // Font
     bool hasFont;
-    RefCountPtr<PDFObject> fontRef;
+    PDFObject* fontRef;
     double fontSize;
 
     // LineWidth
     bool hasLineWidth;
     double lineWidth;
+
+    // constant alpha for texts placed with this state. only read when texts are recorded
+    double constantAlpha;
 };
 
 
@@ -26,11 +35,17 @@ typedef std::map<std::string, GSState> StringToGStateMap;
 
 
 struct Font {
-    Font(RefCountPtr<PDFObject> inRef) {
+    Font(PDFObject* inRef) {
         fontRef = inRef;
+        isBold = false;
+        isItalic = false;
     }
 
-    RefCountPtr<PDFObject> fontRef;
+    PDFObject* fontRef;
+
+    // style, by the font base name. only read when texts are recorded
+    bool isBold;
+    bool isItalic;
 };
 
 typedef std::map<std::string, Font> StringToFontMap;
@@ -16,16 +16,15 @@ struct PlacedTextCommandArgument {
         pos = inPos;
     }
 
-    PlacedTextCommandArgument(const ByteList& inBytes) {
+    PlacedTextCommandArgument(const ByteSpan& inBytes):bytes(inBytes.begin(), inBytes.end()) {
         isText = true;
-        bytes = inBytes;
     }
 
     // choice of what's represented
     bool isText;
     
-    // text data
-    ByteList bytes;
+    // text data. contiguous, so it's read with no copying (as ByteSpan)
+    ByteVector bytes;
 
     // position data
     double pos;
@@ -46,6 +45,16 @@ struct PlacedTextCommand {
 
 typedef std::list<PlacedTextCommand> PlacedTextCommandList;
 
+// PlacedTextCommandRef is a text placement command as it's interpreted, for handlers getting texts per command.
+// the states are references to the interpreter current states rather than snapshots, so they're only good
+// for the duration of the call getting them. isElementStart is set for the first command of a text element
+struct PlacedTextCommandRef {
+    const PlacedTextCommandArgumentList& text;
+    const ContentGraphicState& graphicState;
+    const TextGraphicState& textState;
+    bool isElementStart;
+};
+
 // TextElement matches a pdf text element, which is what's between an BT...ET sequance.
 struct TextElement {
     PlacedTextCommandList texts;
@@ -1,11 +1,14 @@
 #pragma once
 
-#include "RefCountPtr.h"
-#include "PDFObject.h"
 #include "../math/Transformations.h"
 
+#include <stddef.h>
+
+class PDFObject;
+
+// plain data (no owning members), so that it's copied cheaply on q and text placements
 struct TextGraphicState {
-    TextGraphicState():fontRef() {
+    TextGraphicState() {
         charSpace = 0;
         wordSpace = 0;
         scale = 100;
@@ -15,23 +18,10 @@ struct TextGraphicState {
         UnitMatrix(tlm);
         tmDirty = true;
         tlmDirty = true;
+        fontRef = NULL;
         fontSize = 0;
     }
 
-    TextGraphicState(const TextGraphicState& inOther) {
-        charSpace = inOther.charSpace;
-        wordSpace = inOther.wordSpace;
-        scale = inOther.scale;
-        leading = inOther.leading;
-        rise = inOther.rise;
-        CopyMatrix(inOther.tm, tm);
-        CopyMatrix(inOther.tlm, tlm);
-        tmDirty = inOther.tmDirty;
-        tlmDirty = inOther.tlmDirty;
-        fontRef = inOther.fontRef;
-        fontSize = inOther.fontSize;
-    }
-
     double charSpace;
     double wordSpace;
     double scale;
@@ -42,6 +32,7 @@ struct TextGraphicState {
     double tlm[6];
     bool tmDirty;
     bool tlmDirty;
-    RefCountPtr<PDFObject> fontRef;
+    // font object from the interpreter fonts table (see Resources.h). not owned
+    PDFObject* fontRef;
     double fontSize;
 };
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "CancellationToken.h"
+
+using namespace std;
+
+CancellationToken::CancellationToken():cancelled(false) {
+    hasDeadline = false;
+}
+
+void CancellationToken::Cancel() {
+    cancelled = true;
+}
+
+void CancellationToken::SetTimeBudget(unsigned long inMilliseconds) {
+    SetDeadline(chrono::steady_clock::now() + chrono::milliseconds(inMilliseconds));
+}
+
+void CancellationToken::SetDeadline(const chrono::steady_clock::time_point& inDeadline) {
+    hasDeadline = true;
+    deadline = inDeadline;
+}
+
+bool CancellationToken::ShouldStop() const {
+    return IsCancelled() || HasExpired();
+}
+
+bool CancellationToken::IsCancelled() const {
+    return cancelled;
+}
+
+bool CancellationToken::HasExpired() const {
+    return hasDeadline && chrono::steady_clock::now() >= deadline;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * CancellationToken allows stopping an interpretation from outside, either by explicitly cancelling it
+ * (from any thread) or by setting a deadline for it. Interpreters check it between operators (the deadline
+ * only every so many operators, see PDFRecursiveInterpreterBase) and extractions between pages, so stopping
+ * happens shortly after cancelling or passing the deadline.
+ * Set the deadline before starting an interpretation, Cancel can be called at any time.
+ **/
+class CancellationToken {
+    public:
+        CancellationToken();
+
+        void Cancel();
+
+        // stop after a time budget (milliseconds) from now
+        void SetTimeBudget(unsigned long inMilliseconds);
+        void SetDeadline(const std::chrono::steady_clock::time_point& inDeadline);
+
+        // true if either cancelled or past the deadline
+        bool ShouldStop() const;
+        bool IsCancelled() const;
+        bool HasExpired() const;
+
+    private:
+        std::atomic<bool> cancelled;
+        bool hasDeadline;
+        std::chrono::steady_clock::time_point deadline;
+};
@@ -0,0 +1,124 @@
+#include "ContentOperandStack.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace IOBasicTypes;
+
+// parses the text of a number operand, which the lexer already found to be a PDF number (no exponents in PDF)
+static double ParseNumber(const char* inText, size_t inLength) {
+    size_t i = 0;
+    bool negative = false;
+    double value = 0;
+
+    if(i < inLength && (inText[i] == '-' || inText[i] == '+')) {
+        negative = inText[i] == '-';
+        ++i;
+        // some producers write things like --1. take it as -1, like readers do
+        while(i < inLength && inText[i] == '-')
+            ++i;
+    }
+
+    for(; i < inLength && inText[i] >= '0' && inText[i] <= '9'; ++i)
+        value = value * 10 + (inText[i] - '0');
+
+    if(i < inLength && inText[i] == '.') {
+        double scale = 0.1;
+        for(++i; i < inLength && inText[i] >= '0' && inText[i] <= '9'; ++i) {
+            value += (inText[i] - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    return negative ? -value : value;
+}
+
+ContentOperandStack::ContentOperandStack() {
+    operandsCount = 0;
+}
+
+size_t ContentOperandStack::size() const {
+    return operandsCount;
+}
+
+bool ContentOperandStack::empty() const {
+    return operandsCount == 0;
+}
+
+const ContentOperand& ContentOperandStack::operator[](size_t inIndex) const {
+    return operands[inIndex];
+}
+
+const ContentOperand& ContentOperandStack::back() const {
+    return operands[operandsCount - 1];
+}
+
+double ContentOperandStack::GetNumber(size_t inIndex) const {
+    return GetNumber(operands[inIndex]);
+}
+
+double ContentOperandStack::GetNumber(const ContentOperand& inOperand) const {
+    if(IsNumber(inOperand))
+        return ParseNumber(bytes.data() + inOperand.offset, inOperand.length);
+    return inOperand.type == eContentOperandBoolean ? inOperand.number : 0;
+}
+
+bool ContentOperandStack::IsNumber(const ContentOperand& inOperand) const {
+    return inOperand.type == eContentOperandNumber;
+}
+
+string ContentOperandStack::GetText(size_t inIndex) const {
+    return GetText(operands[inIndex]);
+}
+
+string ContentOperandStack::GetText(const ContentOperand& inOperand) const {
+    if(inOperand.type != eContentOperandName && inOperand.type != eContentOperandString)
+        return string();
+    return bytes.substr(inOperand.offset, inOperand.length);
+}
+
+const Byte* ContentOperandStack::GetBytes(const ContentOperand& inOperand) const {
+    return (const Byte*)bytes.data() + inOperand.offset;
+}
+
+const ContentOperand& ContentOperandStack::GetArrayItem(const ContentOperand& inArray, size_t inIndex) const {
+    return arrayItems[inArray.offset + inIndex];
+}
+
+void ContentOperandStack::Clear() {
+    // keeps the buffers capacity, so next operators can reuse them
+    operandsCount = 0;
+    arrayItems.clear();
+    bytes.clear();
+}
+
+void ContentOperandStack::Push(const ContentOperand& inOperand) {
+    if(operandsCount == scMaxOperands) {
+        // too many. drop the first one, operators use the last ones
+        memmove(operands, operands + 1, sizeof(ContentOperand) * (scMaxOperands - 1));
+        --operandsCount;
+    }
+    operands[operandsCount++] = inOperand;
+}
+
+void ContentOperandStack::BeginArray() {
+    ContentOperand anArray = {eContentOperandArray, 0, arrayItems.size(), 0};
+    Push(anArray);
+}
+
+void ContentOperandStack::PushArrayItem(const ContentOperand& inOperand) {
+    arrayItems.push_back(inOperand);
+    ++operands[operandsCount - 1].length;
+}
+
+size_t ContentOperandStack::GetBytesSize() const {
+    return bytes.size();
+}
+
+void ContentOperandStack::AppendByte(Byte inByte) {
+    bytes.push_back((char)inByte);
+}
+
+void ContentOperandStack::TruncateBytes(size_t inSize) {
+    bytes.resize(inSize);
+}
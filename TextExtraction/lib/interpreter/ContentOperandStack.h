@@ -0,0 +1,80 @@
+#pragma once
+
+#include "IOBasicTypes.h"
+
+#include <string>
+#include <vector>
+
+enum EContentOperandType {
+    eContentOperandNumber,
+    eContentOperandBoolean,
+    eContentOperandNull,
+    eContentOperandName,
+    eContentOperandString, // literal and hex strings alike, already decoded
+    eContentOperandArray,
+    eContentOperandDictionary // content is not kept. only happens as marked content properties
+};
+
+/**
+ * A content stream operand, as a tagged value. Names and strings refer to bytes kept by the stack,
+ * and arrays refer to items kept by the stack, so operands are only valid while the stack holds them.
+ **/
+struct ContentOperand {
+    EContentOperandType type;
+    // booleans value, 1 or 0
+    double number;
+    // numbers, names and strings - offset and length of the bytes in the stack bytes buffer. numbers are kept
+    // as their text, and parsed on GetNumber, so operands that no operator asks for are never parsed.
+    // arrays - index of the first item and items count. (arrays nested in arrays are kept empty)
+    size_t offset;
+    size_t length;
+};
+
+typedef std::vector<ContentOperand> ContentOperandVector;
+
+/**
+ * ContentOperandStack holds the operands of the operator being interpreted. It's filled by the content stream
+ * lexer and reused for all operators of a content stream, so once its buffers grew to fit, interpreting
+ * operators doesn't allocate anything.
+ * Operands are kept upto a fixed count. Operators use the last operands, so when there are more
+ * (which is an error in the content stream anyways), the first ones are dropped.
+ **/
+class ContentOperandStack {
+    public:
+        ContentOperandStack();
+
+        // access the operands (not including array items), as with a vector
+        size_t size() const;
+        bool empty() const;
+        const ContentOperand& operator[](size_t inIndex) const;
+        const ContentOperand& back() const;
+
+        // values. GetNumber is 0 for anything but numbers (and booleans), GetText is empty for anything but names and strings
+        double GetNumber(size_t inIndex) const;
+        double GetNumber(const ContentOperand& inOperand) const;
+        std::string GetText(size_t inIndex) const;
+        std::string GetText(const ContentOperand& inOperand) const;
+        const IOBasicTypes::Byte* GetBytes(const ContentOperand& inOperand) const;
+        bool IsNumber(const ContentOperand& inOperand) const;
+
+        // array items, by index from 0 to inArray.length
+        const ContentOperand& GetArrayItem(const ContentOperand& inArray, size_t inIndex) const;
+
+        // filling, for the lexer
+        void Clear();
+        void Push(const ContentOperand& inOperand);
+        void BeginArray();
+        void PushArrayItem(const ContentOperand& inOperand);
+        // bytes for numbers, names and strings are appended to the buffer, and then pushed referring to their offset
+        size_t GetBytesSize() const;
+        void AppendByte(IOBasicTypes::Byte inByte);
+        void TruncateBytes(size_t inSize);
+
+    private:
+        static const size_t scMaxOperands = 64;
+
+        ContentOperand operands[scMaxOperands];
+        size_t operandsCount;
+        ContentOperandVector arrayItems;
+        std::string bytes;
+};
@@ -0,0 +1,96 @@
+#include "ContentOperators.h"
+
+#include <stdint.h>
+
+using namespace std;
+
+// operators are all 1 to 3 chars long, so they pack into a single int, which a switch can quickly look up
+#define OPERATOR_CODE1(a) ((uint32_t)(unsigned char)(a))
+#define OPERATOR_CODE2(a, b) ((OPERATOR_CODE1(a) << 8) | (unsigned char)(b))
+#define OPERATOR_CODE3(a, b, c) ((OPERATOR_CODE2(a, b) << 8) | (unsigned char)(c))
+
+EContentOperator GetContentOperator(const string& inOperator) {
+    uint32_t code = 0;
+
+    if(inOperator.empty() || inOperator.size() > 3)
+        return eOperatorUnknown;
+    for(string::const_iterator it = inOperator.begin(); it != inOperator.end(); ++it)
+        code = (code << 8) | (unsigned char)*it;
+
+    switch(code) {
+        case OPERATOR_CODE1('w'): return eOperatorw;
+        case OPERATOR_CODE1('J'): return eOperatorJ;
+        case OPERATOR_CODE1('j'): return eOperatorj;
+        case OPERATOR_CODE1('M'): return eOperatorM;
+        case OPERATOR_CODE1('d'): return eOperatord;
+        case OPERATOR_CODE2('r', 'i'): return eOperatorri;
+        case OPERATOR_CODE1('i'): return eOperatori;
+        case OPERATOR_CODE2('g', 's'): return eOperatorgs;
+        case OPERATOR_CODE1('q'): return eOperatorq;
+        case OPERATOR_CODE1('Q'): return eOperatorQ;
+        case OPERATOR_CODE2('c', 'm'): return eOperatorcm;
+        case OPERATOR_CODE1('m'): return eOperatorm;
+        case OPERATOR_CODE1('l'): return eOperatorl;
+        case OPERATOR_CODE1('c'): return eOperatorc;
+        case OPERATOR_CODE1('v'): return eOperatorv;
+        case OPERATOR_CODE1('y'): return eOperatory;
+        case OPERATOR_CODE1('h'): return eOperatorh;
+        case OPERATOR_CODE2('r', 'e'): return eOperatorre;
+        case OPERATOR_CODE1('S'): return eOperatorS;
+        case OPERATOR_CODE1('s'): return eOperators;
+        case OPERATOR_CODE1('f'): return eOperatorf;
+        case OPERATOR_CODE1('F'): return eOperatorF;
+        case OPERATOR_CODE2('f', '*'): return eOperatorfStar;
+        case OPERATOR_CODE1('B'): return eOperatorB;
+        case OPERATOR_CODE2('B', '*'): return eOperatorBStar;
+        case OPERATOR_CODE1('b'): return eOperatorb;
+        case OPERATOR_CODE2('b', '*'): return eOperatorbStar;
+        case OPERATOR_CODE1('n'): return eOperatorn;
+        case OPERATOR_CODE1('W'): return eOperatorW;
+        case OPERATOR_CODE2('W', '*'): return eOperatorWStar;
+        case OPERATOR_CODE2('B', 'T'): return eOperatorBT;
+        case OPERATOR_CODE2('E', 'T'): return eOperatorET;
+        case OPERATOR_CODE2('T', 'c'): return eOperatorTc;
+        case OPERATOR_CODE2('T', 'w'): return eOperatorTw;
+        case OPERATOR_CODE2('T', 'z'): return eOperatorTz;
+        case OPERATOR_CODE2('T', 'L'): return eOperatorTL;
+        case OPERATOR_CODE2('T', 'f'): return eOperatorTf;
+        case OPERATOR_CODE2('T', 'r'): return eOperatorTr;
+        case OPERATOR_CODE2('T', 's'): return eOperatorTs;
+        case OPERATOR_CODE2('T', 'd'): return eOperatorTd;
+        case OPERATOR_CODE2('T', 'D'): return eOperatorTD;
+        case OPERATOR_CODE2('T', 'm'): return eOperatorTm;
+        case OPERATOR_CODE2('T', '*'): return eOperatorTStar;
+        case OPERATOR_CODE2('T', 'j'): return eOperatorTj;
+        case OPERATOR_CODE2('T', 'J'): return eOperatorTJ;
+        case OPERATOR_CODE1('\''): return eOperatorQuote;
+        case OPERATOR_CODE1('"'): return eOperatorDoubleQuote;
+        case OPERATOR_CODE2('d', '0'): return eOperatord0;
+        case OPERATOR_CODE2('d', '1'): return eOperatord1;
+        case OPERATOR_CODE2('C', 'S'): return eOperatorCS;
+        case OPERATOR_CODE2('c', 's'): return eOperatorcs;
+        case OPERATOR_CODE2('S', 'C'): return eOperatorSC;
+        case OPERATOR_CODE3('S', 'C', 'N'): return eOperatorSCN;
+        case OPERATOR_CODE2('s', 'c'): return eOperatorsc;
+        case OPERATOR_CODE3('s', 'c', 'n'): return eOperatorscn;
+        case OPERATOR_CODE1('G'): return eOperatorG;
+        case OPERATOR_CODE1('g'): return eOperatorg;
+        case OPERATOR_CODE2('R', 'G'): return eOperatorRG;
+        case OPERATOR_CODE2('r', 'g'): return eOperatorrg;
+        case OPERATOR_CODE1('K'): return eOperatorK;
+        case OPERATOR_CODE1('k'): return eOperatork;
+        case OPERATOR_CODE2('s', 'h'): return eOperatorsh;
+        case OPERATOR_CODE2('B', 'I'): return eOperatorBI;
+        case OPERATOR_CODE2('I', 'D'): return eOperatorID;
+        case OPERATOR_CODE2('E', 'I'): return eOperatorEI;
+        case OPERATOR_CODE2('D', 'o'): return eOperatorDo;
+        case OPERATOR_CODE2('M', 'P'): return eOperatorMP;
+        case OPERATOR_CODE2('D', 'P'): return eOperatorDP;
+        case OPERATOR_CODE3('B', 'M', 'C'): return eOperatorBMC;
+        case OPERATOR_CODE3('B', 'D', 'C'): return eOperatorBDC;
+        case OPERATOR_CODE3('E', 'M', 'C'): return eOperatorEMC;
+        case OPERATOR_CODE2('B', 'X'): return eOperatorBX;
+        case OPERATOR_CODE2('E', 'X'): return eOperatorEX;
+        default: return eOperatorUnknown;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Content stream operators, as codes. The interpreter maps each operator symbol to its code once, as it's read,
+ * so handlers can dispatch with a switch rather than comparing strings.
+ * names follow the operator text, with * as Star, ' as Quote and " as DoubleQuote.
+ **/
+enum EContentOperator {
+    eOperatorUnknown = 0,
+
+    // general graphics state
+    eOperatorw, eOperatorJ, eOperatorj, eOperatorM, eOperatord, eOperatorri, eOperatori, eOperatorgs,
+    // special graphics state
+    eOperatorq, eOperatorQ, eOperatorcm,
+    // path construction
+    eOperatorm, eOperatorl, eOperatorc, eOperatorv, eOperatory, eOperatorh, eOperatorre,
+    // path painting
+    eOperatorS, eOperators, eOperatorf, eOperatorF, eOperatorfStar, eOperatorB, eOperatorBStar, eOperatorb, eOperatorbStar, eOperatorn,
+    // clipping paths
+    eOperatorW, eOperatorWStar,
+    // text objects
+    eOperatorBT, eOperatorET,
+    // text state
+    eOperatorTc, eOperatorTw, eOperatorTz, eOperatorTL, eOperatorTf, eOperatorTr, eOperatorTs,
+    // text positioning
+    eOperatorTd, eOperatorTD, eOperatorTm, eOperatorTStar,
+    // text showing
+    eOperatorTj, eOperatorTJ, eOperatorQuote, eOperatorDoubleQuote,
+    // type 3 fonts
+    eOperatord0, eOperatord1,
+    // color
+    eOperatorCS, eOperatorcs, eOperatorSC, eOperatorSCN, eOperatorsc, eOperatorscn, eOperatorG, eOperatorg, eOperatorRG, eOperatorrg, eOperatorK, eOperatork,
+    // shading patterns
+    eOperatorsh,
+    // inline images
+    eOperatorBI, eOperatorID, eOperatorEI,
+    // xobjects
+    eOperatorDo,
+    // marked content
+    eOperatorMP, eOperatorDP, eOperatorBMC, eOperatorBDC, eOperatorEMC,
+    // compatibility
+    eOperatorBX, eOperatorEX
+};
+
+EContentOperator GetContentOperator(const std::string& inOperator);
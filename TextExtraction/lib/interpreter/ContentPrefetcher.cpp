@@ -0,0 +1,271 @@
+#include "ContentPrefetcher.h"
+#include "ContentStreamLexer.h"
+#include "ContentOperandStack.h"
+#include "ContentOperators.h"
+
+#include "PDFParser.h"
+#include "PDFObjectCast.h"
+#include "PDFDictionary.h"
+#include "PDFArray.h"
+#include "PDFName.h"
+#include "PDFIndirectObjectReference.h"
+#include "PDFStreamInput.h"
+#include "IByteReader.h"
+#include "RefCountPtr.h"
+
+#include <string>
+#include <algorithm>
+
+using namespace std;
+using namespace IOBasicTypes;
+using namespace PDFHummus;
+
+static const string scResources = "Resources";
+static const string scContents = "Contents";
+static const string scParent = "Parent";
+static const string scXObject = "XObject";
+static const string scSubtype = "Subtype";
+static const string scForm = "Form";
+
+static const size_t scReadSize = 65536;
+
+typedef set<string> StringSet;
+
+static PDFObject* FindInheritedResources(PDFParser* inParser, PDFDictionary* inDictionary) {
+    if(inDictionary->Exists(scResources))
+        return inParser->QueryDictionaryObject(inDictionary, scResources);
+
+    PDFObjectCastPtr<PDFDictionary> parentDict(
+        inDictionary->Exists(scParent) ?
+            inParser->QueryDictionaryObject(inDictionary, scParent):
+            NULL);
+    if(!parentDict)
+        return NULL;
+
+    return FindInheritedResources(inParser, parentDict.GetPtr());
+}
+
+ContentPrefetcher::ContentPrefetcher(const InputSource& inSource, unsigned long inPagesAhead):source(inSource) {
+    pagesAhead = inPagesAhead;
+    stopping = false;
+    nextPageToQueue = 0;
+
+    // a thread per page ahead, leaving a core for the interpreting thread
+    unsigned long cores = thread::hardware_concurrency();
+    unsigned long threadsCount = min(pagesAhead, cores > 1 ? cores - 1 : 1);
+    for(unsigned long i=0; i < threadsCount; ++i)
+        threads.push_back(thread(&ContentPrefetcher::RunPrefetchThread, this));
+}
+
+ContentPrefetcher::~ContentPrefetcher() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+
+    for(ThreadVector::iterator it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+}
+
+void ContentPrefetcher::OnPageStart(unsigned long inPageIndex, unsigned long inLastPage) {
+    {
+        lock_guard<mutex> guard(lock);
+
+        // pages upto this one are already interpreted (or being interpreted), no point in decoding them anymore
+        PageIndexList::iterator itPages = queuedPages.begin();
+        while(itPages != queuedPages.end()) {
+            if(*itPages <= inPageIndex)
+                itPages = queuedPages.erase(itPages);
+            else
+                ++itPages;
+        }
+
+        if(nextPageToQueue <= inPageIndex)
+            nextPageToQueue = inPageIndex + 1;
+        for(; nextPageToQueue <= inLastPage && nextPageToQueue <= inPageIndex + pagesAhead; ++nextPageToQueue)
+            queuedPages.push_back(nextPageToQueue);
+
+        // drop streams no page from this one on uses. streams being decoded are dropped later, once done
+        PositionToDecodedStreamMap::iterator itStreams = streams.begin();
+        while(itStreams != streams.end()) {
+            if(!!itStreams->second.data && itStreams->second.lastPage < inPageIndex)
+                streams.erase(itStreams++);
+            else
+                ++itStreams;
+        }
+    }
+    changed.notify_all();
+}
+
+bool ContentPrefetcher::GetDecodedStream(PDFStreamInput* inStream, DecodedStreamPtr& outData) {
+    LongFilePositionType position = inStream->GetStreamContentStart();
+    unique_lock<mutex> guard(lock);
+
+    while(true) {
+        PositionToDecodedStreamMap::iterator it = streams.find(position);
+        if(it == streams.end())
+            return false;
+
+        if(!!it->second.data) {
+            outData = it->second.data;
+            return true;
+        }
+
+        // on its way. wait for it rather than decoding it again
+        changed.wait(guard);
+    }
+}
+
+bool ContentPrefetcher::IsStopping() {
+    lock_guard<mutex> guard(lock);
+    return stopping;
+}
+
+void ContentPrefetcher::RunPrefetchThread(ContentPrefetcher* inPrefetcher) {
+    // each thread gets its own reader and parser, so that reading positions are not shared with the interpreting thread
+    InputSourceReader sourceReader;
+    if(sourceReader.Open(inPrefetcher->source) != eSuccess)
+        return;
+
+    PDFParser parser;
+    if(parser.StartPDFParsing(sourceReader.GetInputStream()) != eSuccess)
+        return;
+
+    inPrefetcher->PrefetchPages(&parser);
+}
+
+void ContentPrefetcher::PrefetchPages(PDFParser* inParser) {
+    while(true) {
+        unsigned long pageIndex;
+        {
+            unique_lock<mutex> guard(lock);
+            while(!stopping && queuedPages.empty())
+                changed.wait(guard);
+            if(stopping)
+                return;
+            pageIndex = queuedPages.front();
+            queuedPages.pop_front();
+        }
+
+        PrefetchPage(inParser, pageIndex);
+    }
+}
+
+void ContentPrefetcher::PrefetchPage(PDFParser* inParser, unsigned long inPageIndex) {
+    RefCountPtr<PDFDictionary> page(inParser->ParsePage(inPageIndex));
+    if(!page)
+        return;
+
+    RefCountPtr<PDFObject> contents(inParser->QueryDictionaryObject(page.GetPtr(), scContents));
+    if(!contents)
+        return;
+
+    ObjectIDTypeSet visitedForms;
+    if(contents->GetType() == PDFObject::ePDFObjectStream) {
+        PrefetchContent(inParser, (PDFStreamInput*)contents.GetPtr(), page.GetPtr(), inPageIndex, visitedForms);
+    }
+    else if(contents->GetType() == PDFObject::ePDFObjectArray) {
+        PDFArray* contentsArray = (PDFArray*)contents.GetPtr();
+        for(unsigned long i=0; i < contentsArray->GetLength(); ++i) {
+            PDFObjectCastPtr<PDFStreamInput> stream(inParser->QueryArrayObject(contentsArray, i));
+            if(!!stream)
+                PrefetchContent(inParser, stream.GetPtr(), page.GetPtr(), inPageIndex, visitedForms);
+        }
+    }
+}
+
+void ContentPrefetcher::PrefetchContent(PDFParser* inParser, PDFStreamInput* inStream, PDFDictionary* inContentParent, unsigned long inPageIndex, ObjectIDTypeSet& ioVisitedForms) {
+    if(IsStopping())
+        return;
+
+    // streams already known were (or are being) decoded for another page, along with the forms they draw
+    if(!DecodeStream(inParser, inStream, inPageIndex))
+        return;
+
+    // find the forms drawn by the content, to prefetch them as well. the lexer reads the stream just decoded, from memory
+    StringSet formNames;
+    {
+        ContentStreamLexer lexer(inParser, inStream, this);
+        ContentOperandStack operands;
+        string operation;
+
+        while(lexer.ReadOperation(operands, operation)) {
+            EContentOperator operatorCode = GetContentOperator(operation);
+            if(operatorCode == eOperatorDo && operands.size() == 1 && operands[0].type == eContentOperandName)
+                formNames.insert(operands.GetText(0));
+            else if(operatorCode == eOperatorID)
+                lexer.SkipInlineImage();
+        }
+    }
+
+    if(formNames.empty())
+        return;
+
+    PDFObjectCastPtr<PDFDictionary> resources(FindInheritedResources(inParser, inContentParent));
+    if(!resources)
+        return;
+
+    PDFObjectCastPtr<PDFDictionary> xobjects(inParser->QueryDictionaryObject(resources.GetPtr(), scXObject));
+    if(!xobjects)
+        return;
+
+    StringSet::iterator it = formNames.begin();
+    for(; it != formNames.end(); ++it) {
+        PDFObjectCastPtr<PDFIndirectObjectReference> xobjectRef(xobjects->QueryDirectObject(*it));
+        if(!xobjectRef || !ioVisitedForms.insert(xobjectRef->mObjectID).second)
+            continue;
+
+        PDFObjectCastPtr<PDFStreamInput> xobject(inParser->ParseNewObject(xobjectRef->mObjectID));
+        if(!xobject)
+            continue;
+
+        // images are not interpreted, so only forms
+        RefCountPtr<PDFDictionary> xobjectDict(xobject->QueryStreamDictionary());
+        PDFObjectCastPtr<PDFName> subtype(xobjectDict->QueryDirectObject(scSubtype));
+        if(!subtype || subtype->GetValue() != scForm)
+            continue;
+
+        PrefetchContent(inParser, xobject.GetPtr(), xobjectDict.GetPtr(), inPageIndex, ioVisitedForms);
+    }
+}
+
+bool ContentPrefetcher::DecodeStream(PDFParser* inParser, PDFStreamInput* inStream, unsigned long inPageIndex) {
+    LongFilePositionType position = inStream->GetStreamContentStart();
+
+    {
+        lock_guard<mutex> guard(lock);
+        PositionToDecodedStreamMap::iterator it = streams.find(position);
+        if(it != streams.end()) {
+            it->second.lastPage = max(it->second.lastPage, inPageIndex);
+            return false;
+        }
+
+        // mark as being decoded, so the lexer waits for it instead of decoding it on its own
+        DecodedStream decodedStream;
+        decodedStream.lastPage = inPageIndex;
+        streams.insert(PositionToDecodedStreamMap::value_type(position, decodedStream));
+    }
+
+    shared_ptr<ByteVector> data(new ByteVector());
+    IByteReader* reader = inParser->StartReadingFromStream(inStream);
+    if(!!reader) {
+        while(reader->NotEnded()) {
+            size_t offset = data->size();
+            data->resize(offset + scReadSize);
+            size_t readSize = (size_t)reader->Read(data->data() + offset, scReadSize);
+            data->resize(offset + readSize);
+            if(readSize == 0)
+                break;
+        }
+        delete reader;
+    }
+
+    {
+        // streams being decoded are never dropped, so it's still there
+        lock_guard<mutex> guard(lock);
+        streams[position].data = data;
+    }
+    changed.notify_all();
+    return true;
+}
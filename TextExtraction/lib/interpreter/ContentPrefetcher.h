@@ -0,0 +1,80 @@
+#pragma once
+
+#include "IOBasicTypes.h"
+#include "ObjectsBasicTypes.h"
+
+#include "../pdf-writer-enhancers/InputSource.h"
+#include "../pdf-writer-enhancers/Bytes.h"
+
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+class PDFParser;
+class PDFDictionary;
+class PDFStreamInput;
+
+typedef std::shared_ptr<const ByteVector> DecodedStreamPtr;
+
+/**
+ * ContentPrefetcher decodes the content streams of upcoming pages on background threads, so that decompression
+ * runs on other cores while the interpreting thread interprets. Each thread opens the input source on its own (own reader
+ * and parser), and decodes the contents of the pages it's given, along with the forms they draw, into memory.
+ * The content lexer then reads prefetched streams from memory, and any other stream as usual.
+ * Streams are identified by their position in the file, which is the same for any parser of the file, so the
+ * input source must be one that can be opened by multiple readers.
+ **/
+class ContentPrefetcher {
+    public:
+        // decode upto inPagesAhead pages after the page being interpreted
+        ContentPrefetcher(const InputSource& inSource, unsigned long inPagesAhead);
+        ~ContentPrefetcher();
+
+        // call when starting to interpret a page. queues the pages after it (upto inLastPage) for prefetching,
+        // and drops decoded streams that were only used by earlier pages
+        void OnPageStart(unsigned long inPageIndex, unsigned long inLastPage);
+
+        // for the lexer. if the stream was prefetched, returns true with its decoded data (waiting for it if it's still being
+        // decoded). otherwise returns false, and the stream should be read as usual
+        bool GetDecodedStream(PDFStreamInput* inStream, DecodedStreamPtr& outData);
+
+    private:
+        struct DecodedStream {
+            // NULL while being decoded
+            DecodedStreamPtr data;
+            // last page using the stream, to know when it can be dropped
+            unsigned long lastPage;
+        };
+
+        typedef std::map<IOBasicTypes::LongFilePositionType, DecodedStream> PositionToDecodedStreamMap;
+        typedef std::list<unsigned long> PageIndexList;
+        typedef std::set<ObjectIDType> ObjectIDTypeSet;
+        typedef std::vector<std::thread> ThreadVector;
+
+        InputSource source;
+        unsigned long pagesAhead;
+
+        std::mutex lock;
+        std::condition_variable changed;
+        bool stopping;
+        PageIndexList queuedPages;
+        unsigned long nextPageToQueue;
+        PositionToDecodedStreamMap streams;
+        ThreadVector threads;
+
+        static void RunPrefetchThread(ContentPrefetcher* inPrefetcher);
+        void PrefetchPages(PDFParser* inParser);
+        void PrefetchPage(PDFParser* inParser, unsigned long inPageIndex);
+        void PrefetchContent(PDFParser* inParser, PDFStreamInput* inStream, PDFDictionary* inContentParent, unsigned long inPageIndex, ObjectIDTypeSet& ioVisitedForms);
+        bool DecodeStream(PDFParser* inParser, PDFStreamInput* inStream, unsigned long inPageIndex);
+        bool IsStopping();
+
+        // no copying. threads refer to this object
+        ContentPrefetcher(const ContentPrefetcher&);
+        ContentPrefetcher& operator=(const ContentPrefetcher&);
+};
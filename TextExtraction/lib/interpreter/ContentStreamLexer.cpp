@@ -0,0 +1,437 @@
+#include "ContentStreamLexer.h"
+#include "ContentOperandStack.h"
+
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFArray.h"
+#include "PDFStreamInput.h"
+#include "PDFObjectCast.h"
+#include "IByteReader.h"
+#include "InputByteArrayStream.h"
+
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+using namespace IOBasicTypes;
+
+static bool IsWhiteSpace(Byte inByte) {
+    return inByte == 0x20 || inByte == 0xA || inByte == 0xD || inByte == 0x9 || inByte == 0xC || inByte == 0;
+}
+
+static bool IsDelimiter(Byte inByte) {
+    return inByte == '(' || inByte == ')' || inByte == '<' || inByte == '>' || inByte == '[' || inByte == ']' ||
+            inByte == '{' || inByte == '}' || inByte == '/' || inByte == '%';
+}
+
+static int HexValue(Byte inByte) {
+    if(inByte >= '0' && inByte <= '9')
+        return inByte - '0';
+    if(inByte >= 'A' && inByte <= 'F')
+        return inByte - 'A' + 10;
+    if(inByte >= 'a' && inByte <= 'f')
+        return inByte - 'a' + 10;
+    return -1;
+}
+
+// checks if a token is a PDF number (no exponents in PDF). the value itself is parsed by the operands stack, when used
+static bool IsNumberToken(const Byte* inToken, size_t inLength) {
+    size_t i = 0;
+    bool hasDigits = false;
+
+    if(i < inLength && (inToken[i] == '-' || inToken[i] == '+')) {
+        ++i;
+        // some producers write things like --1. take it as -1, like readers do
+        while(i < inLength && inToken[i] == '-')
+            ++i;
+    }
+
+    for(; i < inLength && inToken[i] >= '0' && inToken[i] <= '9'; ++i)
+        hasDigits = true;
+
+    if(i < inLength && inToken[i] == '.') {
+        for(++i; i < inLength && inToken[i] >= '0' && inToken[i] <= '9'; ++i)
+            hasDigits = true;
+    }
+
+    return hasDigits && i == inLength;
+}
+
+static const string scTrue = "true";
+static const string scFalse = "false";
+static const string scNull = "null";
+
+ContentStreamLexer::ContentStreamLexer(PDFParser* inParser, PDFObject* inContents, ContentPrefetcher* inPrefetcher) {
+    parser = inParser;
+    prefetcher = inPrefetcher;
+    nextStreamIndex = 0;
+    currentReader = NULL;
+    buffer = new Byte[scBufferSize];
+    bufferPosition = 0;
+    bufferSize = 0;
+
+    if(!inContents)
+        return;
+
+    if(inContents->GetType() == PDFObject::ePDFObjectStream) {
+        inContents->AddRef();
+        streams.push_back(RefCountPtr<PDFStreamInput>((PDFStreamInput*)inContents));
+    } else if(inContents->GetType() == PDFObject::ePDFObjectArray) {
+        PDFArray* contentsArray = (PDFArray*)inContents;
+        for(unsigned long i = 0; i < contentsArray->GetLength(); ++i) {
+            PDFObjectCastPtr<PDFStreamInput> aStream(parser->QueryArrayObject(contentsArray, i));
+            if(!!aStream)
+                streams.push_back(aStream);
+        }
+    }
+}
+
+ContentStreamLexer::~ContentStreamLexer() {
+    delete currentReader;
+    delete[] buffer;
+}
+
+bool ContentStreamLexer::FillBuffer() {
+    while(true) {
+        if(!!currentReader && currentReader->NotEnded()) {
+            bufferSize = (size_t)currentReader->Read(buffer, scBufferSize);
+            bufferPosition = 0;
+            if(bufferSize > 0)
+                return true;
+        }
+
+        // done with the current stream, move on to the next one.
+        delete currentReader;
+        currentReader = NULL;
+        currentData.reset();
+        if(nextStreamIndex >= streams.size())
+            return false;
+
+        PDFStreamInput* stream = streams[nextStreamIndex++].GetPtr();
+        if(!!prefetcher && prefetcher->GetDecodedStream(stream, currentData))
+            currentReader = new InputByteArrayStream((Byte*)currentData->data(), currentData->size());
+        else
+            currentReader = parser->StartReadingFromStream(stream);
+        if(nextStreamIndex > 1) {
+            // streams are separated as if there was a white space between them
+            buffer[0] = '\n';
+            bufferSize = 1;
+            bufferPosition = 0;
+            return true;
+        }
+    }
+}
+
+bool ContentStreamLexer::ReadByte(Byte& outByte) {
+    if(bufferPosition >= bufferSize && !FillBuffer())
+        return false;
+    outByte = buffer[bufferPosition++];
+    return true;
+}
+
+bool ContentStreamLexer::PeekByte(Byte& outByte) {
+    if(bufferPosition >= bufferSize && !FillBuffer())
+        return false;
+    outByte = buffer[bufferPosition];
+    return true;
+}
+
+bool ContentStreamLexer::SkipWhiteSpacesAndComments(Byte& outByte) {
+    while(ReadByte(outByte)) {
+        if(IsWhiteSpace(outByte))
+            continue;
+
+        if(outByte == '%') {
+            // comment runs till end of line
+            Byte aByte;
+            while(PeekByte(aByte) && aByte != 0xA && aByte != 0xD)
+                ++bufferPosition;
+            continue;
+        }
+
+        return true;
+    }
+    return false;
+}
+
+ContentOperand ContentStreamLexer::ReadName(ContentOperandStack& ioOperands) {
+    size_t offset = ioOperands.GetBytesSize();
+    Byte aByte;
+
+    while(PeekByte(aByte) && !IsWhiteSpace(aByte) && !IsDelimiter(aByte)) {
+        ++bufferPosition;
+        Byte high, low;
+        if(aByte == '#' && PeekByte(high) && HexValue(high) >= 0) {
+            // #xx escape
+            ++bufferPosition;
+            if(PeekByte(low) && HexValue(low) >= 0) {
+                ++bufferPosition;
+                ioOperands.AppendByte((Byte)(HexValue(high) * 16 + HexValue(low)));
+            } else {
+                ioOperands.AppendByte(aByte);
+                ioOperands.AppendByte(high);
+            }
+            continue;
+        }
+        ioOperands.AppendByte(aByte);
+    }
+
+    ContentOperand name = {eContentOperandName, 0, offset, ioOperands.GetBytesSize() - offset};
+    return name;
+}
+
+ContentOperand ContentStreamLexer::ReadLiteralString(ContentOperandStack& ioOperands) {
+    size_t offset = ioOperands.GetBytesSize();
+    int depth = 1; // balanced parentheses are allowed in strings
+    Byte aByte;
+
+    while(ReadByte(aByte)) {
+        if(aByte == ')') {
+            if(--depth == 0)
+                break;
+        } else if(aByte == '(') {
+            ++depth;
+        } else if(aByte == 0xD) {
+            // end of lines are read as \n
+            Byte next;
+            if(PeekByte(next) && next == 0xA)
+                ++bufferPosition;
+            aByte = 0xA;
+        } else if(aByte == '\\') {
+            if(!ReadByte(aByte))
+                break;
+            switch(aByte) {
+                case 'n': aByte = '\n'; break;
+                case 'r': aByte = '\r'; break;
+                case 't': aByte = '\t'; break;
+                case 'b': aByte = '\b'; break;
+                case 'f': aByte = '\f'; break;
+                case 0xD: {
+                    // line continuation
+                    Byte next;
+                    if(PeekByte(next) && next == 0xA)
+                        ++bufferPosition;
+                    continue;
+                }
+                case 0xA:
+                    continue;
+                default:
+                    if(aByte >= '0' && aByte <= '7') {
+                        // octal, upto 3 digits
+                        int value = aByte - '0';
+                        Byte digit;
+                        for(int i = 0; i < 2 && PeekByte(digit) && digit >= '0' && digit <= '7'; ++i) {
+                            value = value * 8 + (digit - '0');
+                            ++bufferPosition;
+                        }
+                        aByte = (Byte)value;
+                    }
+                    // otherwise the char itself, which covers \( \) and \\ (and ignores unknown escapes backslash)
+                    break;
+            }
+        }
+        ioOperands.AppendByte(aByte);
+    }
+
+    ContentOperand aString = {eContentOperandString, 0, offset, ioOperands.GetBytesSize() - offset};
+    return aString;
+}
+
+ContentOperand ContentStreamLexer::ReadHexString(ContentOperandStack& ioOperands) {
+    size_t offset = ioOperands.GetBytesSize();
+    int high = -1;
+    Byte aByte;
+
+    while(ReadByte(aByte) && aByte != '>') {
+        int value = HexValue(aByte);
+        if(value < 0)
+            continue; // white spaces, or junk
+        if(high < 0) {
+            high = value;
+        } else {
+            ioOperands.AppendByte((Byte)(high * 16 + value));
+            high = -1;
+        }
+    }
+    // odd count of digits. last one is as if followed by 0
+    if(high >= 0)
+        ioOperands.AppendByte((Byte)(high * 16));
+
+    ContentOperand aString = {eContentOperandString, 0, offset, ioOperands.GetBytesSize() - offset};
+    return aString;
+}
+
+ContentOperand ContentStreamLexer::ReadRegularToken(Byte inFirstByte, ContentOperandStack& ioOperands) {
+    ContentOperand operand = {eContentOperandNumber, 0, ioOperands.GetBytesSize(), 0};
+    Byte aByte;
+
+    ioOperands.AppendByte(inFirstByte);
+    while(PeekByte(aByte) && !IsWhiteSpace(aByte) && !IsDelimiter(aByte)) {
+        ioOperands.AppendByte(aByte);
+        ++bufferPosition;
+    }
+    operand.length = ioOperands.GetBytesSize() - operand.offset;
+
+    if(IsNumberToken(ioOperands.GetBytes(operand), operand.length))
+        return operand;
+
+    // not a number, so a keyword. move it to the token
+    token.assign((const char*)ioOperands.GetBytes(operand), operand.length);
+    ioOperands.TruncateBytes(operand.offset);
+    operand.type = eContentOperandNull;
+    operand.length = 0;
+    return operand;
+}
+
+bool ContentStreamLexer::ReadOperation(ContentOperandStack& ioOperands, string& outOperator) {
+    // containers are either an array directly in the operands, which items are kept, or anything nested
+    // in it or in a dictionary, which are read through but not kept (not used by any operator)
+    bool inArray = false;
+    int skippedDepth = 0;
+    Byte aByte;
+
+    ioOperands.Clear();
+
+    while(SkipWhiteSpacesAndComments(aByte)) {
+        ContentOperand operand = {eContentOperandNull, 0, 0, 0};
+        size_t bytesSize = ioOperands.GetBytesSize();
+        bool isContainerStart = false;
+
+        switch(aByte) {
+            case '[':
+                isContainerStart = true;
+                operand.type = eContentOperandArray;
+                break;
+            case ']':
+                if(skippedDepth > 0)
+                    --skippedDepth;
+                else
+                    inArray = false;
+                continue;
+            case '<': {
+                Byte next;
+                if(PeekByte(next) && next == '<') {
+                    ++bufferPosition;
+                    isContainerStart = true;
+                    operand.type = eContentOperandDictionary;
+                } else {
+                    operand = ReadHexString(ioOperands);
+                }
+                break;
+            }
+            case '>': {
+                Byte next;
+                if(PeekByte(next) && next == '>') {
+                    ++bufferPosition;
+                    if(skippedDepth > 0)
+                        --skippedDepth;
+                }
+                continue;
+            }
+            case '(':
+                operand = ReadLiteralString(ioOperands);
+                break;
+            case '/':
+                operand = ReadName(ioOperands);
+                break;
+            case ')':
+            case '{':
+            case '}':
+                // stray delimiters. ignore
+                continue;
+            default:
+                // numbers are kept as text in the operands bytes, so their value is only parsed if an operator asks for it.
+                // that way operands of operators that the handler skips (say, paths for text extraction) cost just the scan
+                operand = ReadRegularToken(aByte, ioOperands);
+                if(operand.type == eContentOperandNumber)
+                    break;
+
+                if(token == scTrue || token == scFalse) {
+                    operand.type = eContentOperandBoolean;
+                    operand.number = token == scTrue ? 1 : 0;
+                } else if(token == scNull) {
+                    operand.type = eContentOperandNull;
+                } else if(skippedDepth > 0) {
+                    // keywords inside a dictionary. can't be an operator, ignore
+                    continue;
+                } else {
+                    // an operator. done with this operation (an array still open here is just cut short)
+                    outOperator = token;
+                    return true;
+                }
+                break;
+        }
+
+        // place the operand, or drop it if it's inside a skipped container
+        if(skippedDepth > 0) {
+            ioOperands.TruncateBytes(bytesSize);
+            if(isContainerStart)
+                ++skippedDepth;
+        } else if(inArray) {
+            if(isContainerStart) {
+                // nested containers are kept as empty ones
+                operand.offset = 0;
+                operand.length = 0;
+                ++skippedDepth;
+            }
+            ioOperands.PushArrayItem(operand);
+        } else if(isContainerStart && operand.type == eContentOperandArray) {
+            ioOperands.BeginArray();
+            inArray = true;
+        } else {
+            ioOperands.Push(operand);
+            if(isContainerStart)
+                ++skippedDepth;
+        }
+    }
+
+    return false;
+}
+
+void ContentStreamLexer::SkipBytes(size_t inCount) {
+    while(inCount > 0 && (bufferPosition < bufferSize || FillBuffer())) {
+        size_t available = min(inCount, bufferSize - bufferPosition);
+        bufferPosition += available;
+        inCount -= available;
+    }
+}
+
+void ContentStreamLexer::SkipInlineImage(size_t inDataLength) {
+    /*
+        now we're right after ID and need to get to EI. the image data is not parsed, so look for a
+        white space followed by EI. it'd be fooled by such a sequence in the image data, but that's
+        as good as it gets without decoding the image. when the data length is known the data is skipped
+        first (past the white space following ID), so only what's between the data and EI is looked through.
+    */
+    if(inDataLength > 0)
+        SkipBytes(inDataLength + 1);
+
+    // look for E's a buffer at a time, and check what's around them
+    bool previousIsWhiteSpace = false;
+
+    while(bufferPosition < bufferSize || FillBuffer()) {
+        const Byte* start = buffer + bufferPosition;
+        const Byte* end = buffer + bufferSize;
+        const Byte* found = (const Byte*)memchr(start, 'E', end - start);
+
+        if(!found) {
+            previousIsWhiteSpace = IsWhiteSpace(*(end - 1));
+            bufferPosition = bufferSize;
+            continue;
+        }
+
+        bool isAfterWhiteSpace = found == start ? previousIsWhiteSpace : IsWhiteSpace(*(found - 1));
+        bufferPosition = (found - buffer) + 1;
+        previousIsWhiteSpace = false;
+        if(!isAfterWhiteSpace)
+            continue;
+
+        Byte next;
+        if(!PeekByte(next))
+            return;
+        if(next == 'I') {
+            ++bufferPosition;
+            return;
+        }
+    }
+}
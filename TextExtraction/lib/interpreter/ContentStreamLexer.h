@@ -0,0 +1,71 @@
+#pragma once
+
+#include "IOBasicTypes.h"
+#include "RefCountPtr.h"
+
+#include "ContentPrefetcher.h"
+
+#include <string>
+#include <vector>
+
+class PDFParser;
+class PDFObject;
+class PDFStreamInput;
+class IByteReader;
+class ContentOperandStack;
+struct ContentOperand;
+
+typedef std::vector<RefCountPtr<PDFStreamInput> > PDFStreamInputVector;
+
+/**
+ * ContentStreamLexer reads content stream operations - operands followed by an operator - straight from
+ * the decoded stream bytes, into a ContentOperandStack. Unlike reading with PDFObjectParser, no objects are created
+ * for operands, which makes quite a difference for content streams, where most everything is a number.
+ * Contents may be a single stream or an array of streams, which are read as one.
+ * Given a prefetcher, streams it has decoded are read from memory.
+ **/
+class ContentStreamLexer {
+    public:
+        ContentStreamLexer(PDFParser* inParser, PDFObject* inContents, ContentPrefetcher* inPrefetcher = NULL);
+        ~ContentStreamLexer();
+
+        // reads the next operation. the operands are placed in ioOperands (which is cleared first), and the operator in outOperator.
+        // returns false when there are no more operations.
+        bool ReadOperation(ContentOperandStack& ioOperands, std::string& outOperator);
+
+        // skips the data of an inline image, after its ID operator, upto and including EI.
+        // pass the image data length (L/Length entry) if known, so the data is skipped without looking through it
+        void SkipInlineImage(size_t inDataLength = 0);
+
+        // raw access to the content bytes, for readers of inline images data. returns false at the end
+        bool ReadByte(IOBasicTypes::Byte& outByte);
+
+    private:
+        static const size_t scBufferSize = 65536;
+
+        PDFParser* parser;
+        PDFStreamInputVector streams;
+        size_t nextStreamIndex;
+        IByteReader* currentReader;
+        ContentPrefetcher* prefetcher;
+        // data of the current stream, when read from the prefetcher
+        DecodedStreamPtr currentData;
+
+        // on the heap, as forms interpretation nests lexers
+        IOBasicTypes::Byte* buffer;
+        size_t bufferPosition;
+        size_t bufferSize;
+        std::string token;
+
+        bool FillBuffer();
+        bool PeekByte(IOBasicTypes::Byte& outByte);
+        bool SkipWhiteSpacesAndComments(IOBasicTypes::Byte& outByte);
+        void SkipBytes(size_t inCount);
+
+        // names and strings bytes are appended to the operands stack bytes, and the returned operand refers to them
+        ContentOperand ReadName(ContentOperandStack& ioOperands);
+        ContentOperand ReadLiteralString(ContentOperandStack& ioOperands);
+        ContentOperand ReadHexString(ContentOperandStack& ioOperands);
+        // numbers are returned as number operands. anything else is a keyword, placed in token (and returned as a null operand)
+        ContentOperand ReadRegularToken(IOBasicTypes::Byte inFirstByte, ContentOperandStack& ioOperands);
+};
@@ -7,13 +7,15 @@
 #include <list>
 
 #include "../text-parsing/ParsedTextPlacement.h"
+#include "ContentOperators.h"
+#include "ContentOperandStack.h"
 
 
 class PDFObject;
 class PDFStreamInput;
 class PDFParser;
 class PDFDictionary;
-class PDFObjectParser;
+class ContentStreamLexer;
 
 typedef std::vector<PDFObject*> PDFObjectVector;
 typedef std::list<std::string> StringList;
@@ -28,11 +30,16 @@ class IInterpreterContext {
     virtual PDFDictionary* FindResourceCategory(const std::string& inResourceCategory) = 0;
     virtual PDFObject* FindResource(const std::string& inResourceName, const std::string& inResourceCategory) = 0;
 
-    // GetObjectParser fetches you the object parser the interpreter is using to read operators and operands.
+    // GetContentLexer fetches you the lexer the interpreter is using to read operators and operands.
     // You can use this guy  while interpretation. no worries. even read ahead...
-    // this is good for cases where you want to read operators/operands in advance or even read ahead in the stream.
-    // note that parser will become available only once intepretation starts!
-    virtual PDFObjectParser* GetObjectParser() =0;
+    // this is good for cases where you want to read operators/operands in advance or even read inline images data.
+    // note that lexer will become available only once intepretation starts!
+    virtual ContentStreamLexer* GetContentLexer() =0;
+
+    // GetResourcesObjectID returns the object ID of the resources dictionary of the interpreted content (possibly inherited
+    // from a parent pages node), or 0 if the resources dictionary is direct or missing. contents sharing resources
+    // share the resources object, so use this to keep resources parsing results around and not read them again
+    virtual ObjectIDType GetResourcesObjectID() = 0;
 
     TextParameters textParameters;
 };
@@ -49,8 +56,11 @@ public:
 
     // required!
 
-    // return boolean marks whether to continue or not (true or false)
-	virtual bool OnOperation(const std::string& inOperation,  const PDFObjectVector& inOperands, IInterpreterContext* inContext) = 0;
+    // return boolean marks whether to continue or not (true or false).
+    // inOperator is the operation code, which is eOperatorUnknown for anything but the standard operators.
+    // prefer switching on it over comparing inOperation, this gets called for every operation.
+    // operands are only valid during the call, as the stack is reused for the next operation.
+	virtual bool OnOperation(EContentOperator inOperator, const std::string& inOperation,  const ContentOperandStack& inOperands, IInterpreterContext* inContext) = 0;
 
 
     // Optional helpers
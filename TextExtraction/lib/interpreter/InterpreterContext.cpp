@@ -0,0 +1,95 @@
+#include "InterpreterContext.h"
+
+#include "PDFObjectCast.h"
+#include "PDFParser.h"
+#include "PDFIndirectObjectReference.h"
+
+using namespace std;
+
+static PDFObject* FindInheritedResources(PDFParser* inParser,PDFDictionary* inDictionary, ObjectIDType& outResourcesObjectID) {
+	if(inDictionary->Exists("Resources")) {
+		RefCountPtr<PDFObject> resourcesEntry(inDictionary->QueryDirectObject("Resources"));
+		outResourcesObjectID = resourcesEntry->GetType() == PDFObject::ePDFObjectIndirectObjectReference ? 
+			((PDFIndirectObjectReference*)resourcesEntry.GetPtr())->mObjectID : 
+			0;
+		return inParser->QueryDictionaryObject(inDictionary, "Resources");
+	}
+	else {
+		PDFObjectCastPtr<PDFDictionary> parentDict(
+			inDictionary->Exists("Parent") ? 
+				inParser->QueryDictionaryObject(inDictionary, "Parent"): 
+				NULL);
+		if(!parentDict) {
+			return NULL;
+		}
+		else {
+			return FindInheritedResources(inParser,parentDict.GetPtr(), outResourcesObjectID);
+		}
+		
+	}
+}
+
+InterpreterContext::InterpreterContext(PDFParser* inParser, PDFDictionary* inContentParent) {
+    parser = inParser;
+    contentParent = inContentParent;
+    contentLexer = NULL;
+    resourcesResolved = false;
+    resourcesObjectID = 0;
+}
+
+void InterpreterContext::SetContentLexer(ContentStreamLexer* inContentLexer) {
+    contentLexer = inContentLexer;    
+}
+
+void InterpreterContext::ResolveResources() {
+    if(resourcesResolved)
+        return;
+
+    PDFObjectCastPtr<PDFDictionary> resourcesDict(FindInheritedResources(parser, contentParent, resourcesObjectID));
+    resources = resourcesDict;
+    resourcesResolved = true;
+}
+
+ObjectIDType InterpreterContext::GetResourcesObjectID() {
+    ResolveResources();
+    return resourcesObjectID;
+}
+
+PDFDictionary* InterpreterContext::FindResourceCategory(const string& inResourceCategory) {
+    StringToPDFDictionaryMap::iterator it = categories.find(inResourceCategory);
+
+    if(it == categories.end()) {
+        ResolveResources();
+
+        RefCountPtr<PDFDictionary> category;
+        if(!!resources) {
+            PDFObjectCastPtr<PDFDictionary> categoryDictionary(parser->QueryDictionaryObject(resources.GetPtr(), inResourceCategory));
+            category = categoryDictionary; // wanted the objectcastptr to also verify for dict
+        }
+        // missing categories are kept as well, so they're not looked for again
+        it = categories.insert(StringToPDFDictionaryMap::value_type(inResourceCategory, category)).first;
+    }
+
+    if(!it->second)
+        return NULL;
+
+    it->second->AddRef(); // caller owns the result
+    return it->second.GetPtr();
+}
+
+PDFObject* InterpreterContext::FindResource(const string& inResourceName, const string& inResourceCategory) {
+    RefCountPtr<PDFDictionary> categoryDict = FindResourceCategory(inResourceCategory);
+
+    if(!categoryDict)
+        return NULL;
+
+    return categoryDict->QueryDirectObject(inResourceName);
+}
+
+PDFParser* InterpreterContext::GetParser() {
+    return parser;
+}
+
+ContentStreamLexer* InterpreterContext::GetContentLexer() {
+    return contentLexer;
+}
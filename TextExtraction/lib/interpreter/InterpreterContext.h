@@ -0,0 +1,37 @@
+#pragma once
+
+#include "RefCountPtr.h"
+#include "PDFDictionary.h"
+
+#include "IPDFRecursiveInterpreterHandler.h"
+
+#include <map>
+#include <string>
+
+typedef std::map<std::string, RefCountPtr<PDFDictionary> > StringToPDFDictionaryMap;
+
+// InterpreterContext is the interpreter implementation of IInterpreterContext, one per interpreted content (page or form)
+class InterpreterContext: public IInterpreterContext {
+    public:
+        InterpreterContext(PDFParser* inParser, PDFDictionary* inContentParent);
+    
+        virtual PDFDictionary* FindResourceCategory(const std::string& inResourceCategory);
+        virtual PDFObject* FindResource(const std::string& inResourceName, const std::string& inResourceCategory);
+        virtual PDFParser* GetParser();
+        virtual ContentStreamLexer* GetContentLexer();
+        virtual ObjectIDType GetResourcesObjectID();
+
+        void SetContentLexer(ContentStreamLexer* inContentLexer);
+    private:
+        PDFParser* parser;
+        PDFDictionary* contentParent;
+        ContentStreamLexer* contentLexer;
+
+        // resources and categories are resolved once per context, on first use
+        bool resourcesResolved;
+        RefCountPtr<PDFDictionary> resources;
+        ObjectIDType resourcesObjectID;
+        StringToPDFDictionaryMap categories;
+
+        void ResolveResources();
+};
@@ -1,61 +1,248 @@
 #pragma once
 #include <list>
+#include <string>
 
 #include "IOBasicTypes.h"
+#include "RefCountPtr.h"
+#include "PDFParser.h"
+#include "PDFDictionary.h"
+#include "PDFStreamInput.h"
+
 #include "IPDFRecursiveInterpreterHandler.h"
+#include "InterpreterContext.h"
+#include "ContentStreamLexer.h"
+#include "ContentOperandStack.h"
 
 typedef std::list<ObjectIDType> ObjectIDTypeList;
 
-class PDFParser;
-class PDFDictionary;
-class PDFStreamInput;
-class PDFObjectParser;
-class InterpreterContext;
+class CancellationToken;
+class ContentPrefetcher;
 
-class PDFRecursiveInterpreter {
+// PDFRecursiveInterpreterBase holds what's common to recursive interpreters of any handler type
+class PDFRecursiveInterpreterBase {
 public:
-    PDFRecursiveInterpreter(void);
-    virtual ~PDFRecursiveInterpreter(void);
+    PDFRecursiveInterpreterBase(void);
+
+    // when set, interpretation stops (returning false) once the token is cancelled or expired.
+    // cancelling is checked between operators, and the deadline at the start of every content stream and every
+    // scDeadlineCheckInterval operators after, sparing a clock read per operator. the token is passed on to forms interpretation
+    void SetCancellationToken(const CancellationToken* inCancellationToken);
+
+    // when set, content streams the prefetcher decoded ahead are read from memory. passed on to forms interpretation as well
+    void SetContentPrefetcher(ContentPrefetcher* inContentPrefetcher);
+
+protected:
+    struct PDFNestingContext {
+        ObjectIDTypeList nestedXObjects;
+    };
+
+    PDFNestingContext* mNestingContext;
+    const CancellationToken* mCancellationToken;
+    ContentPrefetcher* mContentPrefetcher;
 
+    static const unsigned long scDeadlineCheckInterval = 256;
+
+    // inOperationsCount is the count of operations read so far from the current content stream
+    bool ShouldStop(unsigned long inOperationsCount) const;
+
+    // Do operator support. StartForm finds the xobject placed (outForm is left empty if it's not a form), and returns false
+    // if it's already being interpreted (looping forms). EndForm should follow a successful StartForm.
+    bool StartForm(
+        PDFParser* inParser,
+        IInterpreterContext* inContext,
+        const std::string& inFormName,
+        ObjectIDType& outFormObjectID,
+        RefCountPtr<PDFStreamInput>& outForm,
+        IOBasicTypes::LongFilePositionType& outParserPosition);
+    void EndForm(PDFParser* inParser, IOBasicTypes::LongFilePositionType inParserPosition);
+
+    static size_t GetInlineImageDataLength(const ContentOperandStack& inOperands);
+};
+
+/**
+ * PDFRecursiveInterpreterT interprets content, calling a handler of type THandler. THandler is expected to implement
+ * the IPDFRecursiveInterpreterHandler methods, and calls to it are made through the handler type, rather than through the interface.
+ * So a handler that's a final class gets its methods called directly (and possibly inlined into the operators loop),
+ * instead of through a virtual call per operator.
+ * PDFRecursiveInterpreter is the interpreter for any IPDFRecursiveInterpreterHandler.
+ **/
+template <class THandler>
+class PDFRecursiveInterpreterT : public PDFRecursiveInterpreterBase {
+public:
     bool InterpretPageContents(
         PDFParser* inParser,
         PDFDictionary* inPage,
-        IPDFRecursiveInterpreterHandler* inHandler);
+        THandler* inHandler);
 
     bool InterpretXObjectContents(
         PDFParser* inParser,
         PDFStreamInput* inXObject,
-        IPDFRecursiveInterpreterHandler* inHandler); 
+        THandler* inHandler); 
 
 private:
-    struct PDFNestingContext {
-        ObjectIDTypeList nestedXObjects;
-    };
-
-    PDFNestingContext* mNestingContext;
-
     // internal method used by higher level interpreters to call lower level xobject interpreters with nesting context
     bool InterpretXObjectContents(
         PDFParser* inParser,
         PDFStreamInput* inXObject,
-        IPDFRecursiveInterpreterHandler* inHandler,
+        THandler* inHandler,
         PDFNestingContext* inNestingContext);     
 
     // internal method for intrepreting xobjects
     bool InterpretXObjectContentsInternal(
         PDFParser* inParser,
         PDFStreamInput* inXObject,
-        IPDFRecursiveInterpreterHandler* inHandler);       
+        THandler* inHandler);       
 
     bool InterpretContentStream(
         PDFParser* inParser,
-        PDFDictionary* inContentParent,
-        PDFObjectParser* inObjectParser,
+        PDFObject* inContents,
         InterpreterContext* inContext,
-        IPDFRecursiveInterpreterHandler* inHandler
+        THandler* inHandler
+    );
+};
+
+typedef PDFRecursiveInterpreterT<IPDFRecursiveInterpreterHandler> PDFRecursiveInterpreter;
+
+// instantiated once, in PDFRecursiveInterpreter.cpp
+extern template class PDFRecursiveInterpreterT<IPDFRecursiveInterpreterHandler>;
+
+
+template <class THandler>
+bool PDFRecursiveInterpreterT<THandler>::InterpretContentStream(
+    PDFParser* inParser,
+    PDFObject* inContents,
+    InterpreterContext* inContext,
+    THandler* inHandler
+) {
+    ContentStreamLexer lexer(inParser, inContents, mContentPrefetcher);
+    inContext->SetContentLexer(&lexer);
+
+    // operands and operator are reused for all operations of the stream
+    ContentOperandStack operands;
+    std::string operation;
+    bool shouldContinue = true;
+    unsigned long operationsCount = 0;
+
+    while(shouldContinue && lexer.ReadOperation(operands, operation)) {
+        if(ShouldStop(operationsCount++)) {
+            // stopped from outside. drop this operation and quit
+            shouldContinue = false;
+            break;
+        }
+
+        // Call handler for operation event
+        EContentOperator operatorCode = GetContentOperator(operation);
+        shouldContinue = inHandler->OnOperation(operatorCode, operation, operands, inContext);
+        if(!shouldContinue)
+            break;
+
+        // now for implementing the special operations
+        if(operatorCode == eOperatorDo && operands.size() == 1 && operands[0].type == eContentOperandName) {
+            // k. user didn't cancel, let's dive into form
+            std::string formName = operands.GetText(0);
+            ObjectIDType formObjectID;
+            RefCountPtr<PDFStreamInput> formObject;
+            IOBasicTypes::LongFilePositionType currentPosition;
+            if(!StartForm(inParser, inContext, formName, formObjectID, formObject, currentPosition)) {
+                // orcish mischief! looping. halt
+                shouldContinue = false;
+                break;
+            }
+
+            if(!!formObject) {  
+                bool shouldRecurse = inHandler->OnXObjectDoStart(formName, formObjectID, formObject.GetPtr(), inParser);
+                if(shouldRecurse) {
+                    PDFRecursiveInterpreterT<THandler> subordinateInterpreter;
+                    subordinateInterpreter.SetCancellationToken(mCancellationToken);
+                    subordinateInterpreter.SetContentPrefetcher(mContentPrefetcher);
+                    shouldContinue = subordinateInterpreter.InterpretXObjectContents(
+                        inParser,
+                        formObject.GetPtr(),
+                        inHandler
+                    );
+                }
+                inHandler->OnXObjectDoEnd(formName, formObjectID, formObject.GetPtr(), inParser);
+            }
+
+            EndForm(inParser, currentPosition);
+        } else if(operatorCode == eOperatorID && inHandler->ShouldSkipInlineImage()) {
+            lexer.SkipInlineImage(GetInlineImageDataLength(operands));
+            // for completion, have onOperation for EI
+            operands.Clear();
+            shouldContinue = inHandler->OnOperation(eOperatorEI, "EI", operands, inContext);
+        }
+    }
+
+    inContext->SetContentLexer(NULL);
+
+    return shouldContinue;
+}
+
+template <class THandler>
+bool PDFRecursiveInterpreterT<THandler>::InterpretPageContents(
+    PDFParser* inParser,
+    PDFDictionary* inPage,
+    THandler* inHandler) {
+
+    
+    RefCountPtr<PDFObject> contents(inParser->QueryDictionaryObject(inPage, "Contents"));
+    if(!contents)
+        return true;
+        
+    InterpreterContext context(inParser, inPage);
+    inHandler->OnResourcesRead(&context);
+
+    if(contents->GetType() != PDFObject::ePDFObjectArray && contents->GetType() != PDFObject::ePDFObjectStream)
+        return true;
+
+    return InterpretContentStream(inParser, contents.GetPtr(), &context, inHandler);
+}
+
+template <class THandler>
+bool PDFRecursiveInterpreterT<THandler>::InterpretXObjectContents(
+    PDFParser* inParser,
+    PDFStreamInput* inXObject,
+    THandler* inHandler) {
+    // root levels xobject content interpretation, context created here
+    PDFNestingContext rootNestingContext;
+
+    mNestingContext = &rootNestingContext;
+    bool result = InterpretXObjectContentsInternal(
+        inParser,
+        inXObject,
+        inHandler
     );
+    mNestingContext = NULL;
+    return result;
+}
 
-    void SkipInlinImageTillEI(
-        PDFObjectParser* inObjectParser
+template <class THandler>
+bool PDFRecursiveInterpreterT<THandler>::InterpretXObjectContents(
+    PDFParser* inParser,
+    PDFStreamInput* inXObject,
+    THandler* inHandler,
+    PDFNestingContext* inNestingContext) {
+        
+    // lower levels xobject content interpretation, context coming from higher levels
+    mNestingContext = inNestingContext;
+    bool result = InterpretXObjectContentsInternal(
+        inParser,
+        inXObject,
+        inHandler
     );
-};
+    mNestingContext = NULL;
+    return result;
+}
+
+template <class THandler>
+bool PDFRecursiveInterpreterT<THandler>::InterpretXObjectContentsInternal(
+    PDFParser* inParser,
+    PDFStreamInput* inXObject,
+    THandler* inHandler) {
+    RefCountPtr<PDFDictionary> xobjectDict(inXObject->QueryStreamDictionary());
+
+    InterpreterContext context(inParser, xobjectDict.GetPtr());
+    inHandler->OnResourcesRead(&context);
+
+    return InterpretContentStream(inParser, inXObject, &context, inHandler);
+}
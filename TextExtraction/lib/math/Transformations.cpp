@@ -30,6 +30,20 @@ void MultiplyMatrix(const double (&inMatrixA)[6], const double (&inMatrixB)[6],
     outResult[5] = inMatrixA[4]*inMatrixB[1] + inMatrixA[5]*inMatrixB[3] + inMatrixB[5];
 }
 
+bool InverseMatrix(const double (&inMatrix)[6], double (&outResult)[6]) {
+    double determinant = inMatrix[0]*inMatrix[3] - inMatrix[1]*inMatrix[2];
+    if(determinant == 0)
+        return false;
+
+    outResult[0] = inMatrix[3]/determinant;
+    outResult[1] = -inMatrix[1]/determinant;
+    outResult[2] = -inMatrix[2]/determinant;
+    outResult[3] = inMatrix[0]/determinant;
+    outResult[4] = (inMatrix[2]*inMatrix[5] - inMatrix[3]*inMatrix[4])/determinant;
+    outResult[5] = (inMatrix[1]*inMatrix[4] - inMatrix[0]*inMatrix[5])/determinant;
+    return true;
+}
+
 void CopyVector(const double (&vector)[2], double (&vectorResult)[2]) {
     vectorResult[0] = vector[0];
     vectorResult[1] = vector[1];
@@ -5,6 +5,8 @@ void ZeroVector(double (&vectorResult)[3]);
 void UnitMatrix(double (&mtxResult)[6]);
 void CopyMatrix(const double (&mtx)[6], double (&mtxResult)[6]);
 void MultiplyMatrix(const double (&mtxA)[6], const double (&mtxB)[6], double (&mtxResult)[6]);
+// returns false (leaving the result untouched) for a non invertible matrix
+bool InverseMatrix(const double (&mtx)[6], double (&mtxResult)[6]);
 void CopyBox(const double (&box)[4], double (&boxResult)[4]);
 void TransformBox(const double (&box)[4],const double (&mtx)[6], double (&boxResult)[4]);
 void CopyVector(const double (&vector)[2], double (&vectorResult)[2]);
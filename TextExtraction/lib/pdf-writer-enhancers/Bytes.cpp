@@ -6,27 +6,21 @@
 
 using namespace std;
 
-ByteList ToBytesList(PDFObject* inObject) {
-    ByteList result;
-    
+ByteVector ToBytes(PDFObject* inObject) {
     switch(inObject->GetType())
     {
         case PDFObject::ePDFObjectLiteralString: {
             string str = ((PDFLiteralString*)inObject)->GetValue();
-            for(string::iterator it = str.begin();it != str.end(); ++it)
-                result.push_back((IOBasicTypes::Byte)(*it));
-            break;
+            return ByteVector(str.begin(), str.end());
         }
         case PDFObject::ePDFObjectHexString: {
             string str = ((PDFHexString*)inObject)->GetValue();
-            for(string::iterator it = str.begin();it != str.end(); ++it)
-                result.push_back((IOBasicTypes::Byte)(*it));
-            break;
+            return ByteVector(str.begin(), str.end());
         }
         default: {
             // nothing
         }
     }
 
-    return result;  
-}
\ No newline at end of file
+    return ByteVector();  
+}
@@ -1,9 +1,37 @@
+#pragma once
+
 #include "IOBasicTypes.h"
 
-#include <list>
+#include <vector>
+#include <stddef.h>
 
-typedef std::list<IOBasicTypes::Byte> ByteList;
+typedef std::vector<IOBasicTypes::Byte> ByteVector;
 class PDFObject;
 
+// ByteSpan is a view of contiguous bytes held elsewhere (a ByteVector, a string, operands bytes), for reading bytes
+// with no copying. it's only good as long as what it views is
+struct ByteSpan {
+    ByteSpan() {
+        data = NULL;
+        size = 0;
+    }
+
+    ByteSpan(const IOBasicTypes::Byte* inData, size_t inSize) {
+        data = inData;
+        size = inSize;
+    }
+
+    ByteSpan(const ByteVector& inBytes) {
+        data = inBytes.empty() ? NULL : &inBytes[0];
+        size = inBytes.size();
+    }
+
+    const IOBasicTypes::Byte* begin() const {return data;}
+    const IOBasicTypes::Byte* end() const {return data + size;}
+
+    const IOBasicTypes::Byte* data;
+    size_t size;
+};
+
 
-ByteList ToBytesList(PDFObject* inObject);
\ No newline at end of file
+ByteVector ToBytes(PDFObject* inObject);
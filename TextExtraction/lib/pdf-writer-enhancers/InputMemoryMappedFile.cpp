@@ -0,0 +1,138 @@
+#include "InputMemoryMappedFile.h"
+
+#include "IByteReaderWithPosition.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace PDFHummus;
+
+InputMemoryMappedFile::InputMemoryMappedFile() {
+    data = NULL;
+    size = 0;
+#ifdef _WIN32
+    fileHandle = NULL;
+    mappingHandle = NULL;
+#endif
+}
+
+InputMemoryMappedFile::~InputMemoryMappedFile() {
+    CloseFile();
+}
+
+#ifdef _WIN32
+
+EStatusCode InputMemoryMappedFile::OpenFile(const string& inFilePath) {
+    CloseFile();
+
+    HANDLE file = CreateFileA(inFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        return eFailure;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return eFailure;
+    }
+    fileHandle = file;
+
+    // empty files can't be mapped. leave as an empty stream
+    if(fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(!mapping) {
+            CloseFile();
+            return eFailure;
+        }
+        mappingHandle = mapping;
+
+        data = (IOBasicTypes::Byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(!data) {
+            CloseFile();
+            return eFailure;
+        }
+        size = (size_t)fileSize.QuadPart;
+    }
+
+    inputStream.Assign(data, (IOBasicTypes::LongFilePositionType)size);
+    return eSuccess;
+}
+
+EStatusCode InputMemoryMappedFile::CloseFile() {
+    if(data)
+        UnmapViewOfFile(data);
+    if(mappingHandle)
+        CloseHandle((HANDLE)mappingHandle);
+    if(fileHandle)
+        CloseHandle((HANDLE)fileHandle);
+
+    data = NULL;
+    size = 0;
+    mappingHandle = NULL;
+    fileHandle = NULL;
+    inputStream.Assign(NULL, 0);
+    return eSuccess;
+}
+
+#else
+
+EStatusCode InputMemoryMappedFile::OpenFile(const string& inFilePath) {
+    CloseFile();
+
+    int file = open(inFilePath.c_str(), O_RDONLY);
+    if(file < 0)
+        return eFailure;
+
+    struct stat fileStat;
+    if(fstat(file, &fileStat) != 0) {
+        close(file);
+        return eFailure;
+    }
+
+    // empty files can't be mapped. leave as an empty stream
+    if(fileStat.st_size > 0) {
+        void* mapped = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if(mapped == MAP_FAILED) {
+            close(file);
+            return eFailure;
+        }
+        data = (IOBasicTypes::Byte*)mapped;
+        size = (size_t)fileStat.st_size;
+    }
+
+    // the mapping stays valid after closing the descriptor
+    close(file);
+
+    inputStream.Assign(data, (IOBasicTypes::LongFilePositionType)size);
+    return eSuccess;
+}
+
+EStatusCode InputMemoryMappedFile::CloseFile() {
+    if(data)
+        munmap(data, size);
+
+    data = NULL;
+    size = 0;
+    inputStream.Assign(NULL, 0);
+    return eSuccess;
+}
+
+#endif
+
+IByteReaderWithPosition* InputMemoryMappedFile::GetInputStream() {
+    return &inputStream;
+}
+
+const IOBasicTypes::Byte* InputMemoryMappedFile::GetData() {
+    return data;
+}
+
+size_t InputMemoryMappedFile::GetSize() {
+    return size;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "EStatusCode.h"
+#include "IOBasicTypes.h"
+#include "InputByteArrayStream.h"
+
+#include <string>
+
+class IByteReaderWithPosition;
+
+/**
+ * Read only memory mapped file, as an alternative to InputFile. Reading is done straight from the mapped memory,
+ * so seeks are just pointer changes and the OS page cache does the actual IO. Good for large files.
+ **/
+
+class InputMemoryMappedFile {
+    public:
+        InputMemoryMappedFile();
+        ~InputMemoryMappedFile();
+
+        PDFHummus::EStatusCode OpenFile(const std::string& inFilePath);
+        PDFHummus::EStatusCode CloseFile();
+
+        IByteReaderWithPosition* GetInputStream();
+        const IOBasicTypes::Byte* GetData();
+        size_t GetSize();
+
+    private:
+        IOBasicTypes::Byte* data;
+        size_t size;
+        InputByteArrayStream inputStream;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+};
@@ -0,0 +1,89 @@
+#include "InputSource.h"
+
+#include "IByteReaderWithPosition.h"
+
+using namespace std;
+using namespace PDFHummus;
+
+InputSource::InputSource(const std::string& inFilePath, bool inShouldMemoryMap) {
+    type = inShouldMemoryMap ? eInputSourceMemoryMappedFile : eInputSourceFile;
+    filePath = inFilePath;
+    buffer = NULL;
+    bufferSize = 0;
+    stream = NULL;
+}
+
+InputSource::InputSource(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize) {
+    type = eInputSourceBuffer;
+    buffer = inBuffer;
+    bufferSize = inBufferSize;
+    stream = NULL;
+}
+
+InputSource::InputSource(IByteReaderWithPosition* inStream) {
+    type = eInputSourceStream;
+    buffer = NULL;
+    bufferSize = 0;
+    stream = inStream;
+}
+
+bool InputSource::CanOpenMultipleReaders() const {
+    return type != eInputSourceStream;
+}
+
+string InputSource::GetDescription() const {
+    switch(type) {
+        case eInputSourceFile:
+        case eInputSourceMemoryMappedFile:
+            return string("file ") + filePath;
+        case eInputSourceBuffer:
+            return string("memory buffer");
+        default:
+            return string("input stream");
+    }
+}
+
+InputSourceReader::InputSourceReader() {
+    inputStream = NULL;
+}
+
+InputSourceReader::~InputSourceReader() {
+
+}
+
+EStatusCode InputSourceReader::Open(const InputSource& inSource) {
+    switch(inSource.type) {
+        case InputSource::eInputSourceFile: {
+            EStatusCode status = file.OpenFile(inSource.filePath);
+            if(status != eSuccess)
+                return status;
+            inputStream = file.GetInputStream();
+            break;
+        }
+        case InputSource::eInputSourceMemoryMappedFile: {
+            // each reader maps on its own. same file mappings share the OS page cache so there's no extra memory cost to that
+            EStatusCode status = memoryMappedFile.OpenFile(inSource.filePath);
+            if(status != eSuccess)
+                return status;
+            inputStream = memoryMappedFile.GetInputStream();
+            break;
+        }
+        case InputSource::eInputSourceBuffer: {
+            // byte array stream only ever reads from the array, so it's safe to pass it the const buffer
+            bufferStream.Assign((IOBasicTypes::Byte*)inSource.buffer, (IOBasicTypes::LongFilePositionType)inSource.bufferSize);
+            inputStream = &bufferStream;
+            break;
+        }
+        default: {
+            if(!inSource.stream)
+                return eFailure;
+            inputStream = inSource.stream;
+        }
+    }
+
+    return eSuccess;
+}
+
+IByteReaderWithPosition* InputSourceReader::GetInputStream() {
+    return inputStream;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "EStatusCode.h"
+#include "IOBasicTypes.h"
+#include "InputFile.h"
+#include "InputByteArrayStream.h"
+#include "InputMemoryMappedFile.h"
+
+#include <string>
+
+class IByteReaderWithPosition;
+
+/**
+ * InputSource describes where a PDF is read from - a file (read normally or memory mapped), a memory buffer or a caller provided stream.
+ * Files and buffers can be opened any number of times for independent reading (say, one reader per worker),
+ * while a caller provided stream can only serve a single reader.
+ * Buffers and streams are not copied nor owned, and should outlive any reading from them.
+ **/
+
+class InputSource {
+    public:
+        explicit InputSource(const std::string& inFilePath, bool inShouldMemoryMap = false);
+        InputSource(const IOBasicTypes::Byte* inBuffer, size_t inBufferSize);
+        explicit InputSource(IByteReaderWithPosition* inStream);
+
+        bool CanOpenMultipleReaders() const;
+
+        // for error messages
+        std::string GetDescription() const;
+
+    private:
+        friend class InputSourceReader;
+
+        enum EInputSourceType {
+            eInputSourceFile,
+            eInputSourceMemoryMappedFile,
+            eInputSourceBuffer,
+            eInputSourceStream
+        };
+
+        EInputSourceType type;
+        std::string filePath;
+        const IOBasicTypes::Byte* buffer;
+        size_t bufferSize;
+        IByteReaderWithPosition* stream;
+};
+
+/**
+ * InputSourceReader opens an input source for reading, holding whatever the reading requires (file handle etc.)
+ * for as long as it lives.
+ **/
+class InputSourceReader {
+    public:
+        InputSourceReader();
+        ~InputSourceReader();
+
+        PDFHummus::EStatusCode Open(const InputSource& inSource);
+        IByteReaderWithPosition* GetInputStream();
+
+    private:
+        InputFile file;
+        InputMemoryMappedFile memoryMappedFile;
+        InputByteArrayStream bufferStream;
+        IByteReaderWithPosition* inputStream;
+};
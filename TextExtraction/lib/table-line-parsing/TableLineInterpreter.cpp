@@ -42,18 +42,19 @@ void TransformPathPoint(const PathPoint& inPathPoint, const double (&inMatrix)[6
 bool TableLineInterpreter::OnStrokePathPainted(const PathElement& inPathElement) {
     bool shouldContinue = true;
 
-    SubPathList::const_iterator it = inPathElement.path.subPaths.begin();
+    SubPathVector::const_iterator it = inPathElement.path.subPaths.begin();
     for(; it != inPathElement.path.subPaths.end() && shouldContinue; ++it) {
         // acceptable subpaths are 2 points paths that are either vertical or horizontal
 
-        if(it->components.size() != 2)
+        if(it->componentsCount != 2)
             continue;
         
         // 2 components...just make sure they are not curves
+        PathComponentSpan components = inPathElement.path.GetComponents(*it);
         bool hasCurve = false;
 
-        PathComponentList::const_iterator itPoints = it->components.begin();
-        for(;itPoints != it->components.end() && !hasCurve;++itPoints) {
+        const PathComponent* itPoints = components.begin();
+        for(;itPoints != components.end() && !hasCurve;++itPoints) {
             hasCurve = itPoints->isCubicBezier;
         }
 
@@ -65,10 +66,8 @@ bool TableLineInterpreter::OnStrokePathPainted(const PathElement& inPathElement)
         // note that for extra safety this property of them must be relevant to those points AFTER having applied the transformation matrix applied to this path graphic state
         double globalPointOne[2];
         double globalPointTwo[2];
-        itPoints = it->components.begin();
-
-        TransformPathPoint(itPoints->to, inPathElement.graphicState.ctm, globalPointOne);
-        TransformPathPoint((++itPoints)->to, inPathElement.graphicState.ctm, globalPointTwo);
+        TransformPathPoint(components[0].to, inPathElement.graphicState.ctm, globalPointOne);
+        TransformPathPoint(components[1].to, inPathElement.graphicState.ctm, globalPointTwo);
         
         // compute effective width
         double widthVector[2] = {inPathElement.graphicState.lineWidth, inPathElement.graphicState.lineWidth};
@@ -130,16 +129,17 @@ bool TableLineInterpreter::OnFillPathPainted(const PathElement& inPathElement) {
 
     bool shouldContinue = true;
 
-    SubPathList::const_iterator it = inPathElement.path.subPaths.begin();
+    SubPathVector::const_iterator it = inPathElement.path.subPaths.begin();
     for(; it != inPathElement.path.subPaths.end() && shouldContinue; ++it) {
-        if(it->components.size() != 5)
+        if(it->componentsCount != 5)
             continue;
         
         // 5 components...just make sure they are not curves
+        PathComponentSpan components = inPathElement.path.GetComponents(*it);
         bool hasCurve = false;
 
-        PathComponentList::const_iterator itPoints = it->components.begin();
-        for(;itPoints != it->components.end() && !hasCurve;++itPoints) {
+        const PathComponent* itPoints = components.begin();
+        for(;itPoints != components.end() && !hasCurve;++itPoints) {
             hasCurve = itPoints->isCubicBezier;
         }
 
@@ -148,8 +148,8 @@ bool TableLineInterpreter::OnFillPathPainted(const PathElement& inPathElement) {
         }
 
         // and make sure the last one is the same as the first one
-        if(it->components.back().to.x != it->components.front().to.x ||
-            it->components.back().to.y != it->components.front().to.y
+        if(components.back().to.x != components.front().to.x ||
+            components.back().to.y != components.front().to.y
         )
             continue;
 
@@ -159,12 +159,10 @@ bool TableLineInterpreter::OnFillPathPainted(const PathElement& inPathElement) {
         double globalPointThree[2];
         double globalPointFour[2];
         PointSet rectPoints;
-        itPoints = it->components.begin();
-
-        TransformPathPoint(itPoints->to, inPathElement.graphicState.ctm,globalPointOne);
-        TransformPathPoint((++itPoints)->to, inPathElement.graphicState.ctm,globalPointTwo);
-        TransformPathPoint((++itPoints)->to, inPathElement.graphicState.ctm,globalPointThree);
-        TransformPathPoint((++itPoints)->to, inPathElement.graphicState.ctm,globalPointFour);
+        TransformPathPoint(components[0].to, inPathElement.graphicState.ctm,globalPointOne);
+        TransformPathPoint(components[1].to, inPathElement.graphicState.ctm,globalPointTwo);
+        TransformPathPoint(components[2].to, inPathElement.graphicState.ctm,globalPointThree);
+        TransformPathPoint(components[3].to, inPathElement.graphicState.ctm,globalPointFour);
 
         rectPoints.insert(&globalPointOne);
         rectPoints.insert(&globalPointTwo);
@@ -175,7 +173,6 @@ bool TableLineInterpreter::OnFillPathPainted(const PathElement& inPathElement) {
         PointSet::iterator itRectPoints = rectPoints.begin();
         double (*lowerLeft)[2] = *itRectPoints;
         double (*upperRight)[2] = *itRectPoints;
-        ++itPoints;
         for(; itRectPoints != rectPoints.end(); ++ itRectPoints) {
             double (*currentPoint)[2] = *itRectPoints;
             if(IsEpsilonSmallerOrEqual((*currentPoint)[0], (*lowerLeft)[0]) && IsEpsilonSmallerOrEqual((*currentPoint)[1], (*lowerLeft)[1]))
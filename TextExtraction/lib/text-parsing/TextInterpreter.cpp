@@ -20,10 +20,12 @@ static const string scSpace = " ";
 
 TextInterpeter::TextInterpeter(void) {
     SetHandler(NULL);
+    StartTextElement();
 }
 
 TextInterpeter::TextInterpeter(ITextInterpreterHandler* inHandler) {
     SetHandler(inHandler);
+    StartTextElement();
 }
 
 
@@ -34,6 +36,11 @@ TextInterpeter::~TextInterpeter(void) {
 void TextInterpeter::ResetInterpretationState() {
     refrencedFontDecoders.clear();
     embeddedFontDecoders.clear();
+    StartTextElement();
+}
+
+void TextInterpeter::ReleaseEmbeddedFontDecoders() {
+    embeddedFontDecoders.clear();
 }
 
 FontDecoder* TextInterpeter::GetDecoderForFont(PDFObject* inFontReference) {
@@ -54,114 +61,138 @@ FontDecoder* TextInterpeter::GetDecoderForFont(PDFObject* inFontReference) {
     return NULL;
 }
 
+void TextInterpeter::StartTextElement() {
+    hasDefaultTm = false;
+    double identity[6] = {1,0,0,1,0,0};
+    CopyMatrix(identity, nextPlacementDefaultTm);
+}
+
 bool TextInterpeter::OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters) {
     if(!handler)
         return true;
 
     bool shouldContinue = true;
     PlacedTextCommandList::const_iterator commandIt = inTextElement.texts.begin();
-    double matrixBuffer[6];
-    
 
-    bool hasDefaultTm = false;
-    double nextPlacementDefaultTm[6] = {1,0,0,1,0,0}; // variable used to store a default matrix accounting for glyph dispositions
+    StartTextElement();
     for(; commandIt != inTextElement.texts.end() && shouldContinue; ++commandIt) {
-        const PlacedTextCommand& item = *commandIt;
-
-        // local matrix for this item. will be used to determine global box out of item local dimensions
-        double itemTextStateTm[6];
-
-        // choose the matrix affecting this item placement. If matrix changing operators were used in the state then it will be the state matrix,
-        // otherwise the new items matrix is just what was accumulated by accounting for glyph dispositions
-        if(!item.textState.tmDirty && hasDefaultTm)
-            CopyMatrix(nextPlacementDefaultTm, itemTextStateTm);
-        else
-            CopyMatrix(item.textState.tm, itemTextStateTm);
-
-        // Determine a decoder for the text font
-        FontDecoder* decoder = GetDecoderForFont(item.textState.fontRef.GetPtr());
-        if(!decoder)
-            continue;
-
-        CopyMatrix(itemTextStateTm, nextPlacementDefaultTm);
-        hasDefaultTm = true;
-        double descentPlacement = (decoder->descent + item.textState.rise)*item.textState.fontSize/1000;
-        double ascentPlacement = (decoder->ascent + item.textState.rise)*item.textState.fontSize/1000;
-        double spaceWidth = (decoder->spaceWidth*item.textState.fontSize + item.textState.charSpace + item.textState.wordSpace)*item.textState.scale/100; 
-
-        PlacedTextCommandArgumentList::const_iterator argumentIt = item.text.begin();
-        for(;argumentIt != item.text.end() && shouldContinue;++argumentIt) {
-            if(argumentIt->isText) {
-                // compute text argument
-                double accumulatedDisplacement = 0;
-                double minPlacement = 0;
-                double maxPlacement = 0;
-
-                // Translate the text and accumulate
-                FontDecoderResult result = decoder->Translate(argumentIt->bytes);
-
-
-                // Compute the text dimensions and position/matrix
-                DispositionResultList dispositions = decoder->ComputeDisplacements(argumentIt->bytes);
-                DispositionResultList::iterator itDispositions = dispositions.begin();
-                for(; itDispositions != dispositions.end(); ++itDispositions) {
-                    double displacement = itDispositions->width;
-                    unsigned long charCode = itDispositions->code;
-                    double tx = (displacement*item.textState.fontSize + item.textState.charSpace + (charCode == 32 ? item.textState.wordSpace:0))*item.textState.scale/100; 
-                    accumulatedDisplacement+=tx;
-                    if(accumulatedDisplacement<minPlacement)
-                        minPlacement = accumulatedDisplacement;
-                    if(accumulatedDisplacement>maxPlacement)
-                        maxPlacement = accumulatedDisplacement;
-                    double txMatrix[6] = {1,0,0,1,tx,0};  
-                    MultiplyMatrix(txMatrix, nextPlacementDefaultTm, matrixBuffer);
-                    CopyMatrix(matrixBuffer,nextPlacementDefaultTm);
-                }
-
-                // prepare and report this text as text placement
-                double localBBox[4] = {minPlacement, descentPlacement, maxPlacement, ascentPlacement};
-                double globalBBox[4];
-                double globalWidthVector[2];
-                double widthVector[2] = {spaceWidth,0};
-                double zeroVector[2] = {0,0};
-                double transformedWidthVector[2];
-                double transformedZeroVector[2];
-                
-                MultiplyMatrix(itemTextStateTm,item.graphicState.ctm, matrixBuffer);
-                TransformBox(localBBox, matrixBuffer, globalBBox);
-
-                TransformVector(widthVector, matrixBuffer, transformedWidthVector);
-                TransformVector(zeroVector, matrixBuffer, transformedZeroVector);
-                globalWidthVector[0] = abs(transformedWidthVector[0] - transformedZeroVector[0]);
-                globalWidthVector[1] = abs(transformedWidthVector[1] - transformedZeroVector[1]);
-
-
-                ParsedTextPlacement placement(
-                        result.asText,
-                        matrixBuffer,
-                        localBBox,
-                        globalBBox,
-                        spaceWidth,
-                        globalWidthVector,
-                        inParameters
-                );
-
-                shouldContinue = handler->OnParsedTextPlacementComplete(placement);
-            } else {
-                // compute displacements argument effect on position/matrix
-                double tx = ((-argumentIt->pos/1000)*item.textState.fontSize)*item.textState.scale/100;
+        shouldContinue = InterpretTextCommand(commandIt->text, commandIt->graphicState, commandIt->textState, inParameters);
+    }
+
+    return shouldContinue;
+
+}
+
+bool TextInterpeter::OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters) {
+    if(!handler)
+        return true;
+
+    if(inCommand.isElementStart)
+        StartTextElement();
+
+    return InterpretTextCommand(inCommand.text, inCommand.graphicState, inCommand.textState, inParameters);
+}
+
+bool TextInterpeter::InterpretTextCommand(
+    const PlacedTextCommandArgumentList& inText,
+    const ContentGraphicState& inGraphicState,
+    const TextGraphicState& inTextState,
+    const TextParameters& inParameters) {
+    bool shouldContinue = true;
+    double matrixBuffer[6];
+
+    // local matrix for this item. will be used to determine global box out of item local dimensions
+    double itemTextStateTm[6];
+
+    // choose the matrix affecting this item placement. If matrix changing operators were used in the state then it will be the state matrix,
+    // otherwise the new items matrix is just what was accumulated by accounting for glyph dispositions
+    if(!inTextState.tmDirty && hasDefaultTm)
+        CopyMatrix(nextPlacementDefaultTm, itemTextStateTm);
+    else
+        CopyMatrix(inTextState.tm, itemTextStateTm);
+
+    // Determine a decoder for the text font
+    FontDecoder* decoder = GetDecoderForFont(inTextState.fontRef);
+    if(!decoder)
+        return true;
+
+    CopyMatrix(itemTextStateTm, nextPlacementDefaultTm);
+    hasDefaultTm = true;
+    double descentPlacement = (decoder->descent + inTextState.rise)*inTextState.fontSize/1000;
+    double ascentPlacement = (decoder->ascent + inTextState.rise)*inTextState.fontSize/1000;
+    double spaceWidth = (decoder->spaceWidth*inTextState.fontSize + inTextState.charSpace + inTextState.wordSpace)*inTextState.scale/100; 
+
+    PlacedTextCommandArgumentList::const_iterator argumentIt = inText.begin();
+    for(;argumentIt != inText.end() && shouldContinue;++argumentIt) {
+        if(argumentIt->isText) {
+            // compute text argument
+            double accumulatedDisplacement = 0;
+            double minPlacement = 0;
+            double maxPlacement = 0;
+
+            // Translate the text and accumulate
+            FontDecoderResult result = decoder->Translate(argumentIt->bytes);
+
+
+            // Compute the text dimensions and position/matrix
+            DispositionResultList dispositions = decoder->ComputeDisplacements(argumentIt->bytes);
+            DispositionResultList::iterator itDispositions = dispositions.begin();
+            for(; itDispositions != dispositions.end(); ++itDispositions) {
+                double displacement = itDispositions->width;
+                unsigned long charCode = itDispositions->code;
+                double tx = (displacement*inTextState.fontSize + inTextState.charSpace + (charCode == 32 ? inTextState.wordSpace:0))*inTextState.scale/100; 
+                accumulatedDisplacement+=tx;
+                if(accumulatedDisplacement<minPlacement)
+                    minPlacement = accumulatedDisplacement;
+                if(accumulatedDisplacement>maxPlacement)
+                    maxPlacement = accumulatedDisplacement;
                 double txMatrix[6] = {1,0,0,1,tx,0};  
                 MultiplyMatrix(txMatrix, nextPlacementDefaultTm, matrixBuffer);
                 CopyMatrix(matrixBuffer,nextPlacementDefaultTm);
             }
 
-            // for next placements within this item, the new matrix is the accumulated disposition matrix
-            CopyMatrix(nextPlacementDefaultTm, itemTextStateTm);
+            // prepare and report this text as text placement
+            double localBBox[4] = {minPlacement, descentPlacement, maxPlacement, ascentPlacement};
+            double globalBBox[4];
+            double globalWidthVector[2];
+            double widthVector[2] = {spaceWidth,0};
+            double zeroVector[2] = {0,0};
+            double transformedWidthVector[2];
+            double transformedZeroVector[2];
+            
+            MultiplyMatrix(itemTextStateTm,inGraphicState.ctm, matrixBuffer);
+            TransformBox(localBBox, matrixBuffer, globalBBox);
+
+            TransformVector(widthVector, matrixBuffer, transformedWidthVector);
+            TransformVector(zeroVector, matrixBuffer, transformedZeroVector);
+            globalWidthVector[0] = abs(transformedWidthVector[0] - transformedZeroVector[0]);
+            globalWidthVector[1] = abs(transformedWidthVector[1] - transformedZeroVector[1]);
+
+
+            ParsedTextPlacement placement(
+                    result.asText,
+                    matrixBuffer,
+                    localBBox,
+                    globalBBox,
+                    spaceWidth,
+                    globalWidthVector,
+                    inParameters
+            );
+
+            shouldContinue = handler->OnParsedTextPlacementComplete(placement);
+        } else {
+            // compute displacements argument effect on position/matrix
+            double tx = ((-argumentIt->pos/1000)*inTextState.fontSize)*inTextState.scale/100;
+            double txMatrix[6] = {1,0,0,1,tx,0};  
+            MultiplyMatrix(txMatrix, nextPlacementDefaultTm, matrixBuffer);
+            CopyMatrix(matrixBuffer,nextPlacementDefaultTm);
         }
+
+        // for next placements within this item, the new matrix is the accumulated disposition matrix
+        CopyMatrix(nextPlacementDefaultTm, itemTextStateTm);
     }
 
     return shouldContinue;
-
 }
 
 
@@ -172,17 +203,18 @@ bool TextInterpeter::OnResourcesRead(const Resources& inResources, IInterpreterC
     for(; it != inResources.fonts.end(); ++it) {
         // 
 
-        if(it->second.fontRef.GetPtr()->GetType() == PDFObject::ePDFObjectDictionary) {
-            RefCountPtr<PDFObject> fontDict = it->second.fontRef.GetPtr();
+        if(it->second.fontRef->GetType() == PDFObject::ePDFObjectDictionary) {
+            PDFObject* fontDict = it->second.fontRef;
             // embedded, check cache first
             PDFObjectToFontDecoderMap::iterator it = embeddedFontDecoders.find(fontDict);
             if(it == embeddedFontDecoders.end()) {
-                // ok. there's none, use this chance to create a new one
-                embeddedFontDecoders.insert(PDFObjectToFontDecoderMap::value_type(fontDict, FontDecoder(inContext->GetParser(), (PDFDictionary*)fontDict.GetPtr())));
+                // ok. there's none, use this chance to create a new one. the decoders map holds on to the font, as it may outlive the resources
+                fontDict->AddRef();
+                embeddedFontDecoders.insert(PDFObjectToFontDecoderMap::value_type(RefCountPtr<PDFObject>(fontDict), FontDecoder(inContext->GetParser(), (PDFDictionary*)fontDict)));
             }
         }
-        else if(it->second.fontRef.GetPtr()->GetType() == PDFObject::ePDFObjectIndirectObjectReference) {
-            ObjectIDType id = ((PDFIndirectObjectReference*)(it->second.fontRef.GetPtr()))->mObjectID;
+        else if(it->second.fontRef->GetType() == PDFObject::ePDFObjectIndirectObjectReference) {
+            ObjectIDType id = ((PDFIndirectObjectReference*)(it->second.fontRef))->mObjectID;
             ObjectIDTypeToFontDecoderMap::iterator it = refrencedFontDecoders.find(id);
             if(it == refrencedFontDecoders.end()) {
                 PDFObjectCastPtr<PDFDictionary> fontDict = inContext->GetParser()->ParseNewObject(id);
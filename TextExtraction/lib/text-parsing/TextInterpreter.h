@@ -15,10 +15,19 @@ class PDFObject;
 
 class IInterpreterContext;
 
+// orders by object pointer. also compares with plain pointers, so they can be looked up with no RefCountPtr made for them
 struct LessRefCountPDFObject {
+    typedef void is_transparent;
+
     bool operator()( const RefCountPtr<PDFObject>& lhs, const RefCountPtr<PDFObject>& rhs ) const {
         return lhs.GetPtr() < rhs.GetPtr();
     }
+    bool operator()( const RefCountPtr<PDFObject>& lhs, PDFObject* rhs ) const {
+        return lhs.GetPtr() < rhs;
+    }
+    bool operator()( PDFObject* lhs, const RefCountPtr<PDFObject>& rhs ) const {
+        return lhs < rhs.GetPtr();
+    }
 };  
 
 typedef std::map<ObjectIDType, FontDecoder> ObjectIDTypeToFontDecoderMap;
@@ -36,16 +45,30 @@ class TextInterpeter {
         // forwarded by external party implementing IGraphicContentInterpreterHandler
         // with only what's relevant to text
         bool OnTextElementComplete(const TextElement& inTextElement, const TextParameters& inParameters = TextParameters());
+        bool OnTextCommand(const PlacedTextCommandRef& inCommand, const TextParameters& inParameters = TextParameters());
         bool OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext);
 
         void ResetInterpretationState();
+        // drop the decoders of direct (embedded in resources) fonts. those are keyed by their object pointers, which are only good
+        // for as long as their resources are, so are no good past an extraction. decoders of referenced fonts are kept
+        void ReleaseEmbeddedFontDecoders();
     private:
         ITextInterpreterHandler* handler;
 
         // font decoders parsed data
         ObjectIDTypeToFontDecoderMap refrencedFontDecoders;
         PDFObjectToFontDecoderMap embeddedFontDecoders;
+
+        // text element state. matrix accumulated by glyph dispositions, for commands that continue the ones before them
+        bool hasDefaultTm;
+        double nextPlacementDefaultTm[6];
         
         FontDecoder* GetDecoderForFont(PDFObject* inFontReference);     
+        void StartTextElement();
+        bool InterpretTextCommand(
+            const PlacedTextCommandArgumentList& inText,
+            const ContentGraphicState& inGraphicState,
+            const TextGraphicState& inTextState,
+            const TextParameters& inParameters);
 
 };
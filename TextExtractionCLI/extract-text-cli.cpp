@@ -1,5 +1,14 @@
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
 
 #include "EStatusCode.h"
 #include "BoxingBase.h"
@@ -13,13 +22,17 @@
 #include "TableExtraction.h"
 #include "lib/text-composition/TextComposer.h"
 
+#include "extraction-server.h"
+
 using namespace std;
 using namespace PDFHummus;
 
 static void ShowUsage(const string& name)
 {
     cerr << "Usage: " << name << " filepath <option(s)>\n"
-              << "filepath - pdf file path\n"
+              << "   or: " << name << " --serve [/path/to/socket]\n"
+              << "--serve - stay resident and serve JSON lines extraction requests from std input, or from a unix socket if provided. socket connections are served concurrently, each keeping its own parsed document\n"
+              << "filepath - pdf file path. with --batch, a directory, a glob pattern (e.g. /path/to/*.pdf) or a manifest file listing pdf file paths, one per line\n"
               << "Options:\n"
               << "\t-s, --start <d>\t\t\t\tstart text extraction from a page index. use negative numbers to subtract from pages count\n"
               << "\t-e, --end <d>\t\t\t\tend text extraction upto page index. use negative numbers to subtract from pages count\n"
@@ -28,6 +41,14 @@ static void ShowUsage(const string& name)
 #endif
               << "\t-p, --spacing <BOTH|HOR|VER|NONE>\tadd spaces between pieces of text considering their relative positions. default is BOTH\n"
               << "\t-t, --tables\t\t\t\textract tables instead of text. Each table is represented in CSV\n"
+              << "\t-c, --combined\t\t\t\textract both text and tables in a single pass. text is written first, then the tables CSV. with -o tables go to <output>_table<n>.csv files\n"
+              << "\t-m, --mmap\t\t\t\tread the input file through memory mapping. good for very large files\n"
+              << "\t-j, --jobs <d>\t\t\t\tnumber of workers to extract text pages with, in parallel. with --batch, number of files to extract in parallel. default is 1\n"
+              << "\t-r, --region [<page>:]<l,b,r,t>\t\textract only within a page region (left, bottom, right, top in page coordinates). omit the page index to apply to all pages. may be repeated\n"
+              << "\t-P, --prefetch <d>\t\t\tdecode the contents of this many pages ahead of the interpreted page, on background threads\n"
+              << "\t-T, --timeout <d>\t\t\ttime budget per document, in milliseconds. when passed, extraction stops and returns the pages completed so far\n"
+              << "\t-C, --cache /path/to/dir\t\tkeep page results in a cache directory, and reuse them for pages that were already extracted\n"
+              << "\t-B, --batch\t\t\t\textract multiple files in a single run. requires -o with an output directory, where each file result is written along with a summary\n"
               << "\t-o, --output /path/to/file\t\twrite result to output file (or files for tables export)\n"
               << "\t-q, --quiet\t\t\t\tquiet run. only shows errors and warnings\n"
               << "\t-h, --help\t\t\t\tShow this help message\n"
@@ -43,18 +64,475 @@ static const string SPACING_VER = "VER";
 static const string SPACING_NONE = "NONE";
 
 static const string scCSVExtension = ".csv";
+static const string scTextExtension = ".txt";
+static const string scPDFExtension = ".pdf";
 static const string scDot = ".";
+static const string scTableSuffix = "_table";
+static const string scBatchSummaryFileName = "batch_summary.csv";
 
 static const Byte scUTF8Bom[3] = {0xEF,0xBB,0xBF};
 
+// output file paths taken by a batch run. each output (table files included) reserves its path here before writing,
+// so that no two outputs, possibly of different workers, are written to the same file
+class OutputNames {
+    public:
+        // reserves inBasePath + inExtension if free, otherwise inBasePath_<n> + inExtension with the first free n.
+        // returns the reserved path
+        string Reserve(const string& inBasePath, const string& inExtension) {
+            lock_guard<mutex> guard(lock);
+            string filePath = inBasePath + inExtension;
+            for(int ordinal = 1; !names.insert(ToKey(filePath)).second; ++ordinal)
+                filePath = inBasePath + "_" + Int(ordinal).ToString() + inExtension;
+            return filePath;
+        }
+
+    private:
+        mutex lock;
+        set<string> names;
+
+        // file systems may be case insensitive, so names that differ only by case are the same name
+        static string ToKey(const string& inFilePath) {
+            string key = inFilePath;
+            transform(key.begin(), key.end(), key.begin(), ::tolower);
+            return key;
+        }
+};
+
+struct ExtractionOptions {
+    long startPage;
+    long endPage;
+    long bidiFlag;
+    TextComposer::ESpacing spacing;
+    bool extractTables;
+    bool extractCombined;
+    unsigned long jobsCount;
+    unsigned long prefetchPagesCount; // 0 for none
+    RegionsOfInterest regions; // empty for whole pages
+    bool useMemoryMapping;
+    unsigned long timeoutMilliseconds; // 0 for none
+    ExtractionCache* cache; // NULL for none
+    OutputNames* outputNames; // NULL unless in a batch run
+    bool quiet;
+};
+
+// writes each table to a separate CSV, named after the output file path (with a running number for all but the first).
+// with output names (batch runs), table files reserve their names, and so may be further suffixed so as not to overwrite other outputs.
+// with no name suffix the first table file is the output file itself, which is reserved already
+static EStatusCode WriteTablesToCSVFiles(TableExtraction& inTableExtraction, const string& inOutputFilePath, int bidiFlag, TextComposer::ESpacing spacing, bool inReport, ExtractionError& outError, OutputNames* inOutputNames, const string& inNameSuffix = "") {
+    EStatusCode status = eSuccess;
+    size_t extensionPos = inOutputFilePath.find_last_of(scDot);
+    string baseOutputFilePath = inOutputFilePath.substr(0, extensionPos) + inNameSuffix;
+    string filePath  = baseOutputFilePath;
+    int ordinal = 0;
+
+    TableListList::iterator itPages = inTableExtraction.tablesForPages.begin();
+    for(; itPages != inTableExtraction.tablesForPages.end() && status == eSuccess; ++itPages) {
+        TableList::iterator itTables = itPages->begin();
+        for(; itTables != itPages->end() && status == eSuccess; ++itTables) {
+            OutputFile outputFile;
+            string fileFullPath = filePath + scCSVExtension;
+            if(!!inOutputNames && (ordinal > 0 || !inNameSuffix.empty()))
+                fileFullPath = inOutputNames->Reserve(filePath, scCSVExtension);
+            status = outputFile.OpenFile(fileFullPath);
+            if (status != eSuccess) {
+                outError.description = string("Cannot open target file path for writing in") + fileFullPath;
+                if(inReport)
+                    cerr << "Error: " << outError.description.c_str() << endl;
+            } else {
+                outputFile.GetOutputStream()->Write(scUTF8Bom,3);
+                string result = inTableExtraction.GetTableAsCSVText(*itTables,bidiFlag, spacing);
+                InputStringStream textStream(result);
+                OutputStreamTraits streamCopier((IByteWriter*)outputFile.GetOutputStream());
+                status = streamCopier.CopyToOutputStream(&textStream);
+                if(inReport)
+                    cerr << "Wrote table to " << fileFullPath.c_str() << endl;
+            }
+            ++ordinal;
+            filePath = baseOutputFilePath + Int(ordinal).ToString();
+        }
+    }
+
+    return status;
+}
+
+static EStatusCode WriteTextToFile(const string& inText, const string& inOutputFilePath, bool inReport, ExtractionError& outError) {
+    OutputFile outputFile;
+    EStatusCode status = outputFile.OpenFile(inOutputFilePath);
+    if (status != eSuccess) {
+        outError.description = string("Cannot open target file path for writing in") + inOutputFilePath;
+        if(inReport)
+            cerr << "Error: " << outError.description.c_str() << endl;
+        return status;
+    }
+
+    outputFile.GetOutputStream()->Write(scUTF8Bom,3);
+    InputStringStream textStream(inText);
+    OutputStreamTraits streamCopier((IByteWriter*)outputFile.GetOutputStream());
+    status = streamCopier.CopyToOutputStream(&textStream);
+    outputFile.CloseFile();
+    return status;
+}
+
+// writes pages text to the output stream (or std output if none) as they get extracted
+class TextPageWriter : public ITextExtractionPageHandler {
+    public:
+        TextPageWriter(IByteWriter* inOutputStream, bool inQuiet) {
+            outputStream = inOutputStream;
+            quiet = inQuiet;
+        }
+
+        virtual bool OnPageTextPlacementsComplete(unsigned long inPageIndex, const ParsedTextPlacementList& inTextPlacements) {
+            return true;
+        }
+
+        virtual bool OnPageTextComplete(unsigned long inPageIndex, const std::string& inText) {
+            if(outputStream)
+                outputStream->Write((const Byte*)inText.c_str(), inText.size());
+            else if(!quiet)
+                cout<<inText.c_str();
+            return true;
+        }
+
+    private:
+        IByteWriter* outputStream;
+        bool quiet;
+};
+
+// parses [<page>:]<left>,<bottom>,<right>,<top> into the regions
+static bool ParseRegion(const string& inRegion, RegionsOfInterest& ioRegions) {
+    string boxText = inRegion;
+    long pageIndex = -1;
+    size_t colonPos = inRegion.find(':');
+    if(colonPos != string::npos) {
+        pageIndex = Long(inRegion.substr(0, colonPos).c_str());
+        if(pageIndex < 0)
+            return false;
+        boxText = inRegion.substr(colonPos + 1);
+    }
+
+    replace(boxText.begin(), boxText.end(), ',', ' ');
+    stringstream stream(boxText);
+    double box[4];
+    for(int i=0; i < 4; ++i) {
+        if(!(stream >> box[i]))
+            return false;
+    }
+
+    if(pageIndex < 0)
+        ioRegions.AddRegion(box);
+    else
+        ioRegions.AddRegion((unsigned long)pageIndex, box);
+    return true;
+}
+
+static void ReportExtractionResult(EStatusCode inStatus, const ExtractionError& inError, const ExtractionWarningList& inWarnings) {
+    if(inStatus != eSuccess) {
+        cerr << "Error: " << inError.description.c_str() << endl;
+    }
+    ExtractionWarningList::const_iterator it = inWarnings.begin();
+    for(; it != inWarnings.end(); ++it) {
+        cerr << "Warning: " << it->description.c_str() << endl;
+    }
+}
+
+// extraction that ran out of time (or was cancelled) still has the pages completed till then
+static bool HasResults(EStatusCode inStatus, const ExtractionError& inError) {
+    return inStatus == eSuccess || inError.code == eErrorTimeout || inError.code == eErrorCancelled;
+}
+
+// extracts a single file per the options, writing results to the output file path, or std output if it's empty.
+// with inReport errors, warnings and written files are reported to the console, otherwise they are just returned.
+static EStatusCode ExtractFile(const string& inFilePath, const string& inOutputFilePath, const ExtractionOptions& inOptions, bool inReport, ExtractionError& outError, size_t& outWarningsCount) {
+    EStatusCode status;
+    bool writeToOutputFile = !inOutputFilePath.empty();
+
+    outError.code = eErrorNone;
+    outError.description = "";
+    outWarningsCount = 0;
+
+    CancellationToken cancellationToken;
+    if(inOptions.timeoutMilliseconds > 0)
+        cancellationToken.SetTimeBudget(inOptions.timeoutMilliseconds);
+
+    if(inOptions.extractCombined) {
+        // text and tables from the same interpretation pass
+        TableExtraction tableExtraction;
+        tableExtraction.SetUseMemoryMapping(inOptions.useMemoryMapping);
+        tableExtraction.SetPrefetchPagesCount(inOptions.prefetchPagesCount);
+        tableExtraction.SetRegionsOfInterest(inOptions.regions);
+        tableExtraction.SetCancellationToken(&cancellationToken);
+        tableExtraction.SetCache(inOptions.cache);
+        status = tableExtraction.ExtractTables(inFilePath, inOptions.startPage, inOptions.endPage);
+        outError = tableExtraction.LatestError;
+        outWarningsCount = tableExtraction.LatestWarnings.size();
+        if(inReport)
+            ReportExtractionResult(status, tableExtraction.LatestError, tableExtraction.LatestWarnings);
+
+        if(HasResults(status, outError)) {
+            string text = tableExtraction.GetResultsAsText(inOptions.bidiFlag, inOptions.spacing);
+            if(writeToOutputFile) {
+                EStatusCode writeStatus = WriteTextToFile(text, inOutputFilePath, inReport, outError);
+                if(writeStatus == eSuccess) {
+                    if(inReport)
+                        cout <<"Wrote text to " << inOutputFilePath.c_str() << endl;
+                    // suffixed, so tables don't overwrite the text file if it's a csv as well
+                    writeStatus = WriteTablesToCSVFiles(tableExtraction, inOutputFilePath, inOptions.bidiFlag, inOptions.spacing, inReport, outError, inOptions.outputNames, scTableSuffix);
+                }
+                if(writeStatus != eSuccess)
+                    status = writeStatus;
+            } else if(!inOptions.quiet) {
+                cout<<text.c_str();
+                cout<<tableExtraction.GetAllAsCSVText(inOptions.bidiFlag, inOptions.spacing).c_str();
+            }
+        }
+    } else if(inOptions.extractTables) {
+        TableExtraction tableExtraction;
+        tableExtraction.SetUseMemoryMapping(inOptions.useMemoryMapping);
+        tableExtraction.SetPrefetchPagesCount(inOptions.prefetchPagesCount);
+        tableExtraction.SetRegionsOfInterest(inOptions.regions);
+        tableExtraction.SetCancellationToken(&cancellationToken);
+        tableExtraction.SetCache(inOptions.cache);
+        status = tableExtraction.ExtractTables(inFilePath, inOptions.startPage, inOptions.endPage);
+        outError = tableExtraction.LatestError;
+        outWarningsCount = tableExtraction.LatestWarnings.size();
+        if(inReport)
+            ReportExtractionResult(status, tableExtraction.LatestError, tableExtraction.LatestWarnings);
+
+        if(HasResults(status, outError)) {
+            if(writeToOutputFile) {
+                EStatusCode writeStatus = WriteTablesToCSVFiles(tableExtraction, inOutputFilePath, inOptions.bidiFlag, inOptions.spacing, inReport, outError, inOptions.outputNames);
+                if(writeStatus != eSuccess)
+                    status = writeStatus;
+            }
+            else if(!inOptions.quiet)
+                cout<<tableExtraction.GetAllAsCSVText(inOptions.bidiFlag, inOptions.spacing).c_str();
+        }
+
+    } else {
+        OutputFile outputFile;
+        if(writeToOutputFile) {
+            status = outputFile.OpenFile(inOutputFilePath);
+            if (status != eSuccess) {
+                outError.description = string("Cannot open target file path for writing in") + inOutputFilePath;
+                if(inReport)
+                    cerr << "Error: " << outError.description.c_str() << endl;
+                return status;
+            }
+            outputFile.GetOutputStream()->Write(scUTF8Bom,3);
+        }
+
+        // pages text is written as soon as each page is done
+        TextPageWriter pageWriter(writeToOutputFile ? outputFile.GetOutputStream() : NULL, inOptions.quiet);
+        TextExtraction textExtraction;
+        textExtraction.SetJobsCount(inOptions.jobsCount);
+        textExtraction.SetUseMemoryMapping(inOptions.useMemoryMapping);
+        textExtraction.SetPrefetchPagesCount(inOptions.prefetchPagesCount);
+        textExtraction.SetRegionsOfInterest(inOptions.regions);
+        textExtraction.SetCancellationToken(&cancellationToken);
+        textExtraction.SetCache(inOptions.cache);
+        textExtraction.SetPageHandler(&pageWriter, inOptions.bidiFlag, inOptions.spacing);
+        status = textExtraction.ExtractText(inFilePath, inOptions.startPage, inOptions.endPage);
+        outError = textExtraction.LatestError;
+        outWarningsCount = textExtraction.LatestWarnings.size();
+        if(inReport)
+            ReportExtractionResult(status, textExtraction.LatestError, textExtraction.LatestWarnings);
+
+        if(writeToOutputFile) {
+            outputFile.CloseFile();
+            if(status == eSuccess && inReport)
+                cout <<"Wrote text to " << inOutputFilePath.c_str() << endl;
+        }
+    }
+
+    return status;
+}
+
+typedef vector<string> StringVector;
+
+// simple glob style matching, supporting * and ?
+static bool MatchesPattern(const char* inPattern, const char* inName) {
+    if(*inPattern == 0)
+        return *inName == 0;
+    if(*inPattern == '*')
+        return MatchesPattern(inPattern + 1, inName) || (*inName != 0 && MatchesPattern(inPattern, inName + 1));
+    if(*inName == 0)
+        return false;
+    return (*inPattern == '?' || *inPattern == *inName) && MatchesPattern(inPattern + 1, inName + 1);
+}
+
+static bool IsPDFFile(const filesystem::path& inPath) {
+    string extension = inPath.extension().string();
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == scPDFExtension;
+}
+
+// batch input may be a directory (all pdfs in it, recursively), a glob pattern on file names
+// or a manifest file listing file paths, one per line. relative paths in a manifest are relative to the manifest location.
+static bool CollectBatchInputs(const string& inBatchInput, StringVector& outFilePaths, string& outError) {
+    error_code ec;
+    filesystem::path inputPath(inBatchInput);
+
+    if(filesystem::is_directory(inputPath, ec)) {
+        filesystem::recursive_directory_iterator it(inputPath, ec);
+        for(; !ec && it != filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if(it->is_regular_file(ec) && IsPDFFile(it->path()))
+                outFilePaths.push_back(it->path().string());
+        }
+    } else if(inBatchInput.find_first_of("*?") != string::npos) {
+        filesystem::path directory = inputPath.parent_path();
+        string pattern = inputPath.filename().string();
+        if(directory.string().find_first_of("*?") != string::npos) {
+            outError = "Batch patterns may only use wildcards in the file name part";
+            return false;
+        }
+        if(directory.empty())
+            directory = ".";
+        filesystem::directory_iterator it(directory, ec);
+        for(; !ec && it != filesystem::directory_iterator(); it.increment(ec)) {
+            if(it->is_regular_file(ec) && MatchesPattern(pattern.c_str(), it->path().filename().string().c_str()))
+                outFilePaths.push_back(it->path().string());
+        }
+    } else {
+        ifstream manifest(inBatchInput.c_str());
+        if(!manifest) {
+            outError = string("Cannot read batch input ") + inBatchInput;
+            return false;
+        }
+        filesystem::path manifestDirectory = inputPath.parent_path();
+        string line;
+        while(getline(manifest, line)) {
+            // skip empty lines and # comments
+            size_t start = line.find_first_not_of(" \t\r\n");
+            if(start == string::npos || line[start] == '#')
+                continue;
+            size_t end = line.find_last_not_of(" \t\r\n");
+            filesystem::path filePath(line.substr(start, end - start + 1));
+            outFilePaths.push_back(filePath.is_relative() ? (manifestDirectory / filePath).string() : filePath.string());
+        }
+    }
+
+    if(ec) {
+        outError = string("Cannot list batch input ") + inBatchInput + ": " + ec.message();
+        return false;
+    }
+
+    sort(outFilePaths.begin(), outFilePaths.end());
+    return true;
+}
+
+struct BatchItem {
+    string filePath;
+    string outputFilePath;
+    EStatusCode status;
+    ExtractionError error;
+    size_t warningsCount;
+};
+
+typedef vector<BatchItem> BatchItemVector;
+
+static void RunBatchWorker(BatchItemVector* inItems, atomic<size_t>* inNextItem, const ExtractionOptions* inOptions) {
+    while(true) {
+        size_t itemIndex = (*inNextItem)++;
+        if(itemIndex >= inItems->size())
+            break;
+        BatchItem& item = (*inItems)[itemIndex];
+        item.status = ExtractFile(item.filePath, item.outputFilePath, *inOptions, false, item.error, item.warningsCount);
+    }
+}
+
+static string EscapeCSVField(const string& inField) {
+    string result = "\"";
+    for(string::const_iterator it = inField.begin(); it != inField.end(); ++it) {
+        if(*it == '"')
+            result += '"';
+        result += *it;
+    }
+    return result + "\"";
+}
+
+// extracts all batch input files into the output directory, with inJobsCount workers each extracting a whole file at a time.
+// a summary with the status of each file is written to the output directory as well.
+static int ExtractBatch(const string& inBatchInput, const string& inOutputDirectory, unsigned long inJobsCount, const ExtractionOptions& inOptions) {
+    StringVector filePaths;
+    string error;
+    if(!CollectBatchInputs(inBatchInput, filePaths, error)) {
+        cerr << "Error: " << error.c_str() << endl;
+        return 1;
+    }
+
+    error_code ec;
+    filesystem::path outputDirectory(inOutputDirectory);
+    filesystem::create_directories(outputDirectory, ec);
+    if(ec) {
+        cerr << "Error: Cannot create output directory " << inOutputDirectory.c_str() << endl;
+        return 1;
+    }
+
+    // output files are named after the input files. names already taken (same named inputs from different directories,
+    // or an input named like another input numbered output) get a running number. tables files reserve theirs as they're written
+    BatchItemVector items(filePaths.size());
+    OutputNames outputNames;
+    outputNames.Reserve((outputDirectory / scBatchSummaryFileName).string(), "");
+    const string& extension = inOptions.extractTables && !inOptions.extractCombined ? scCSVExtension : scTextExtension;
+    for(size_t i=0; i < filePaths.size(); ++i) {
+        string name = filesystem::path(filePaths[i]).stem().string();
+        items[i].filePath = filePaths[i];
+        items[i].outputFilePath = outputNames.Reserve((outputDirectory / name).string(), extension);
+        items[i].status = eFailure;
+        items[i].warningsCount = 0;
+    }
+
+    // files are already extracted in parallel, so each file gets a single worker
+    ExtractionOptions fileOptions = inOptions;
+    fileOptions.jobsCount = 1;
+    fileOptions.outputNames = &outputNames;
+    atomic<size_t> nextItem(0);
+    size_t workersCount = min<size_t>(inJobsCount, items.size());
+    vector<thread> workers;
+    for(size_t i=1; i < workersCount; ++i)
+        workers.push_back(thread(RunBatchWorker, &items, &nextItem, &fileOptions));
+    RunBatchWorker(&items, &nextItem, &fileOptions);
+    for(vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+        it->join();
+
+    string summaryFilePath = (outputDirectory / scBatchSummaryFileName).string();
+    ofstream summary(summaryFilePath.c_str(), ios::out | ios::binary);
+    if(!summary) {
+        cerr << "Error: Cannot open target file path for writing in" << summaryFilePath.c_str() << endl;
+        return 1;
+    }
+
+    size_t failedCount = 0;
+    summary << "file,status,error code,error,warnings\r\n";
+    for(BatchItemVector::iterator it = items.begin(); it != items.end(); ++it) {
+        if(it->status != eSuccess) {
+            ++failedCount;
+            cerr << "Error: " << it->filePath.c_str() << ": " << it->error.description.c_str() << endl;
+        }
+        summary << EscapeCSVField(it->filePath) << "," <<
+                    (it->status == eSuccess ? "OK" : "FAILED") << "," <<
+                    it->error.code << "," <<
+                    EscapeCSVField(it->error.description) << "," <<
+                    it->warningsCount << "\r\n";
+    }
+    summary.close();
+
+    cout << "Processed " << items.size() << " files: " << items.size() - failedCount << " succeeded, " << failedCount << " failed. Summary written to " << summaryFilePath.c_str() << endl;
+
+    return failedCount == 0 ? 0:1;
+}
+
 int main(int argc, char* argv[])
 {
     if(argc < 2) {
         ShowUsage(argv[0]);
-        return 1;        
+        return 1;
     }
 
     string filePath = argv[1];
+    if(filePath == "-S" || filePath == "--serve")
+        return argc > 2 ? RunExtractionServer(argv[2]) : RunExtractionServer();
+
     bool debugging = false;
     string debugPath = "";
     bool writeToOutputFile = false;
@@ -65,6 +543,14 @@ int main(int argc, char* argv[])
     bool quiet = false;
     long bidiFlag = -1;
     bool extractTables = false;
+    bool extractCombined = false;
+    long jobsCount = 1;
+    long prefetchPagesCount = 0;
+    RegionsOfInterest regions;
+    bool useMemoryMapping = false;
+    bool batch = false;
+    long timeoutMilliseconds = 0;
+    string cacheDirectory = "";
 
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -75,6 +561,62 @@ int main(int argc, char* argv[])
             quiet = true;
         } else if ((arg == "-t") || (arg == "--tables")) {
             extractTables = true;
+        } else if ((arg == "-c") || (arg == "--combined")) {
+            extractCombined = true;
+        } else if ((arg == "-B") || (arg == "--batch")) {
+            batch = true;
+        } else if ((arg == "-m") || (arg == "--mmap")) {
+            useMemoryMapping = true;
+        } else if ((arg == "-j") || (arg == "--jobs")) {
+            if (i + 1 < argc) {
+                jobsCount = Long(argv[++i]);
+                if(jobsCount < 1) {
+                    std::cerr << "--jobs option requires a positive number of workers." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "--jobs option requires one argument, which is the number of workers." << std::endl;
+                return 1;                 
+            }            
+        } else if ((arg == "-r") || (arg == "--region")) {
+            if (i + 1 < argc) {
+                if(!ParseRegion(argv[++i], regions)) {
+                    std::cerr << "--region option requires a region as [<page>:]<left>,<bottom>,<right>,<top>." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "--region option requires one argument, which is the region to extract." << std::endl;
+                return 1;
+            }
+        } else if ((arg == "-P") || (arg == "--prefetch")) {
+            if (i + 1 < argc) {
+                prefetchPagesCount = Long(argv[++i]);
+                if(prefetchPagesCount < 1) {
+                    std::cerr << "--prefetch option requires a positive number of pages." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "--prefetch option requires one argument, which is the number of pages to decode ahead." << std::endl;
+                return 1;                 
+            }            
+        } else if ((arg == "-T") || (arg == "--timeout")) {
+            if (i + 1 < argc) {
+                timeoutMilliseconds = Long(argv[++i]);
+                if(timeoutMilliseconds < 1) {
+                    std::cerr << "--timeout option requires a positive number of milliseconds." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "--timeout option requires one argument, which is the time budget in milliseconds." << std::endl;
+                return 1;                 
+            }            
+        } else if ((arg == "-C") || (arg == "--cache")) {
+            if (i + 1 < argc) {
+                cacheDirectory = argv[++i];
+            } else {
+                std::cerr << "--cache option requires one argument, which is the cache directory path." << std::endl;
+                return 1;                 
+            }            
         } else if ((arg == "-s") || (arg == "--start")) {
             if (i + 1 < argc) {
                 startPage = Long(argv[++i]);
@@ -149,93 +691,47 @@ int main(int argc, char* argv[])
         }
     }    
 
+    ExtractionOptions options;
+    options.startPage = startPage;
+    options.endPage = endPage;
+    options.bidiFlag = bidiFlag;
+    options.spacing = spacing;
+    options.extractTables = extractTables;
+    options.extractCombined = extractCombined;
+    options.jobsCount = (unsigned long)jobsCount;
+    options.prefetchPagesCount = (unsigned long)prefetchPagesCount;
+    options.regions = regions;
+    options.useMemoryMapping = useMemoryMapping;
+    options.timeoutMilliseconds = (unsigned long)timeoutMilliseconds;
+    options.quiet = quiet;
+
+    if(batch && (!writeToOutputFile || debugging)) {
+        std::cerr << "--batch option requires --output with the output directory, and can't be used with --debug." << std::endl;
+        return 1;
+    }
+
+    // a single cache for all files, so batch files with common pages share results as well
+    ExtractionCache* cache = cacheDirectory.empty() ? NULL : new ExtractionCache(cacheDirectory);
+    options.cache = cache;
+    options.outputNames = NULL;
+
+    if(batch) {
+        int result = ExtractBatch(filePath, outputFilePath, (unsigned long)jobsCount, options);
+        delete cache;
+        return result;
+    }
+
     EStatusCode status;
     if(debugging) {
         TextExtraction textExtraction;
         status = textExtraction.DecryptPDFForDebugging(filePath, debugPath);
     } else {
-        if(extractTables) {
-            TableExtraction tableExtraction;
-            status = tableExtraction.ExtractTables(filePath, startPage, endPage);
-
-            if(status != eSuccess) {
-                cerr << "Error: " << tableExtraction.LatestError.description.c_str() << endl;
-            }
-            ExtractionWarningList::iterator it = tableExtraction.LatestWarnings.begin();
-            for(; it != tableExtraction.LatestWarnings.end(); ++it) {
-                cerr << "Warning: " << it->description.c_str() << endl;
-            }    
-
-            if(status == eSuccess) {
-                if(writeToOutputFile) {
-                    size_t extensionPos = outputFilePath.find_last_of(scDot);
-                    string baseOutputFilePath = outputFilePath.substr(0, extensionPos);
-                    string filePath  = baseOutputFilePath;
-                    int ordinal = 0;
-                    
-                    // writing each table to a separate CSV
-                    TableListList::iterator itPages = tableExtraction.tablesForPages.begin();
-                    for(; itPages != tableExtraction.tablesForPages.end() && status == eSuccess; ++itPages) {
-                        TableList::iterator itTables = itPages->begin();
-                        for(; itTables != itPages->end() && status == eSuccess; ++itTables) {
-                            OutputFile outputFile;
-                            string fileFullPath = filePath + scCSVExtension;
-                            status = outputFile.OpenFile(fileFullPath);
-                            if (status != eSuccess) {
-                                cerr << "Error: Cannot open target file path for writing in" << fileFullPath.c_str() << endl;
-                            } else {
-                                outputFile.GetOutputStream()->Write(scUTF8Bom,3);
-                                string result = tableExtraction.GetTableAsCSVText(*itTables,bidiFlag, spacing);
-                                InputStringStream textStream(result);		
-                                OutputStreamTraits streamCopier((IByteWriter*)outputFile.GetOutputStream());
-                                status = streamCopier.CopyToOutputStream(&textStream);
-                                cerr << "Wrote table to " << fileFullPath.c_str() << endl;
-                            }
-                            ++ordinal;
-                            filePath = baseOutputFilePath + Int(ordinal).ToString();
-                        }
-                    }
-                } else if(!quiet) {
-                    cout<<tableExtraction.GetAllAsCSVText(bidiFlag, spacing).c_str();
-                }
-            }
-
-        } else {
-            TextExtraction textExtraction;
-            status = textExtraction.ExtractText(filePath, startPage, endPage);
-
-            if(status != eSuccess) {
-                cerr << "Error: " << textExtraction.LatestError.description.c_str() << endl;
-            }
-            ExtractionWarningList::iterator it = textExtraction.LatestWarnings.begin();
-            for(; it != textExtraction.LatestWarnings.end(); ++it) {
-                cerr << "Warning: " << it->description.c_str() << endl;
-            }    
-
-            if(status == eSuccess) {
-                if(writeToOutputFile) {
-                    OutputFile outputFile;
-                    status = outputFile.OpenFile(outputFilePath);
-                    if (status != eSuccess) {
-                        cerr << "Error: Cannot open target file path for writing in" << outputFilePath.c_str() << endl;
-                    }
-                    else {
-                        outputFile.GetOutputStream()->Write(scUTF8Bom,3);
-                        string result = textExtraction.GetResultsAsText(bidiFlag, spacing);
-                        InputStringStream textStream(result);
-                        OutputStreamTraits streamCopier((IByteWriter*)outputFile.GetOutputStream());
-                        status = streamCopier.CopyToOutputStream(&textStream);
-                    }
-                    cout <<"Wrote text to " << outputFilePath.c_str() << endl;
-
-                }
-                else if(!quiet) {
-                    cout<<textExtraction.GetResultsAsText(bidiFlag, spacing).c_str();
-                }
-            }
-        }
+        ExtractionError error;
+        size_t warningsCount;
+        status = ExtractFile(filePath, writeToOutputFile ? outputFilePath : "", options, true, error, warningsCount);
     }
+    delete cache;
 
 
     return  status == eSuccess ? 0:1;
-}
\ No newline at end of file
+}
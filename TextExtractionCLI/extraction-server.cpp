@@ -0,0 +1,677 @@
+#include "extraction-server.h"
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <system_error>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <errno.h>
+#endif
+
+#include "EStatusCode.h"
+#include "BoxingBase.h"
+
+#include "DocumentSession.h"
+#include "TextExtraction.h"
+#include "TableExtraction.h"
+#include "lib/text-composition/TextComposer.h"
+
+using namespace std;
+using namespace PDFHummus;
+
+static const string scModeText = "text";
+static const string scModeTables = "tables";
+static const string scModeCombined = "combined";
+static const string scBidiLTR = "LTR";
+static const string scBidiRTL = "RTL";
+static const string scSpacingBoth = "BOTH";
+static const string scSpacingHor = "HOR";
+static const string scSpacingVer = "VER";
+static const string scSpacingNone = "NONE";
+static const string scNull = "null";
+static const string scTrue = "true";
+static const string scFalse = "false";
+
+// minimal JSON lines support. requests are flat objects, with string, number, boolean or null values.
+// parsed values are kept as their raw JSON text, other than strings which are unescaped.
+struct JSONValue {
+    string text;
+    bool isString;
+};
+
+typedef map<string, JSONValue> StringToJSONValueMap;
+
+static void SkipWhitespace(const string& inLine, size_t& ioPosition) {
+    while(ioPosition < inLine.size() && (inLine[ioPosition] == ' ' || inLine[ioPosition] == '\t' || inLine[ioPosition] == '\r' || inLine[ioPosition] == '\n'))
+        ++ioPosition;
+}
+
+static void AppendUTF8(string& ioString, unsigned long inCodePoint) {
+    if(inCodePoint < 0x80) {
+        ioString += (char)inCodePoint;
+    } else if(inCodePoint < 0x800) {
+        ioString += (char)(0xC0 | (inCodePoint >> 6));
+        ioString += (char)(0x80 | (inCodePoint & 0x3F));
+    } else if(inCodePoint < 0x10000) {
+        ioString += (char)(0xE0 | (inCodePoint >> 12));
+        ioString += (char)(0x80 | ((inCodePoint >> 6) & 0x3F));
+        ioString += (char)(0x80 | (inCodePoint & 0x3F));
+    } else {
+        ioString += (char)(0xF0 | (inCodePoint >> 18));
+        ioString += (char)(0x80 | ((inCodePoint >> 12) & 0x3F));
+        ioString += (char)(0x80 | ((inCodePoint >> 6) & 0x3F));
+        ioString += (char)(0x80 | (inCodePoint & 0x3F));
+    }
+}
+
+static bool ParseHex4(const string& inLine, size_t inPosition, unsigned long& outValue) {
+    if(inPosition + 4 > inLine.size())
+        return false;
+    outValue = 0;
+    for(size_t i = inPosition; i < inPosition + 4; ++i) {
+        char c = inLine[i];
+        outValue <<= 4;
+        if(c >= '0' && c <= '9')
+            outValue += c - '0';
+        else if(c >= 'a' && c <= 'f')
+            outValue += c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F')
+            outValue += c - 'A' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+static bool ParseJSONString(const string& inLine, size_t& ioPosition, string& outValue) {
+    // at opening quote
+    ++ioPosition;
+    outValue.clear();
+    while(ioPosition < inLine.size()) {
+        char c = inLine[ioPosition++];
+        if(c == '"')
+            return true;
+        if(c != '\\') {
+            outValue += c;
+            continue;
+        }
+        if(ioPosition >= inLine.size())
+            return false;
+        char escaped = inLine[ioPosition++];
+        switch(escaped) {
+            case '"': outValue += '"'; break;
+            case '\\': outValue += '\\'; break;
+            case '/': outValue += '/'; break;
+            case 'b': outValue += '\b'; break;
+            case 'f': outValue += '\f'; break;
+            case 'n': outValue += '\n'; break;
+            case 'r': outValue += '\r'; break;
+            case 't': outValue += '\t'; break;
+            case 'u': {
+                unsigned long codePoint;
+                if(!ParseHex4(inLine, ioPosition, codePoint))
+                    return false;
+                ioPosition += 4;
+                // surrogate pair
+                unsigned long lowSurrogate;
+                if(codePoint >= 0xD800 && codePoint < 0xDC00 &&
+                    ioPosition + 6 <= inLine.size() && inLine[ioPosition] == '\\' && inLine[ioPosition + 1] == 'u' &&
+                    ParseHex4(inLine, ioPosition + 2, lowSurrogate) && lowSurrogate >= 0xDC00 && lowSurrogate < 0xE000) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                    ioPosition += 6;
+                }
+                AppendUTF8(outValue, codePoint);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+static bool IsDigit(char inChar) {
+    return inChar >= '0' && inChar <= '9';
+}
+
+// per the JSON number grammar, -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool IsJSONNumber(const string& inText) {
+    size_t position = 0;
+    if(position < inText.size() && inText[position] == '-')
+        ++position;
+    if(position >= inText.size() || !IsDigit(inText[position]))
+        return false;
+    if(inText[position++] != '0') {
+        while(position < inText.size() && IsDigit(inText[position]))
+            ++position;
+    }
+    if(position < inText.size() && inText[position] == '.') {
+        ++position;
+        if(position >= inText.size() || !IsDigit(inText[position]))
+            return false;
+        while(position < inText.size() && IsDigit(inText[position]))
+            ++position;
+    }
+    if(position < inText.size() && (inText[position] == 'e' || inText[position] == 'E')) {
+        ++position;
+        if(position < inText.size() && (inText[position] == '+' || inText[position] == '-'))
+            ++position;
+        if(position >= inText.size() || !IsDigit(inText[position]))
+            return false;
+        while(position < inText.size() && IsDigit(inText[position]))
+            ++position;
+    }
+    return position == inText.size();
+}
+
+static bool IsJSONLiteral(const string& inText) {
+    return inText == scTrue || inText == scFalse || inText == scNull || IsJSONNumber(inText);
+}
+
+static bool ParseJSONObject(const string& inLine, StringToJSONValueMap& outValues, string& outError) {
+    size_t position = 0;
+    SkipWhitespace(inLine, position);
+    if(position >= inLine.size() || inLine[position] != '{') {
+        outError = "Request should be a JSON object";
+        return false;
+    }
+    ++position;
+
+    SkipWhitespace(inLine, position);
+    if(position < inLine.size() && inLine[position] == '}')
+        return true;
+
+    while(position < inLine.size()) {
+        string key;
+        SkipWhitespace(inLine, position);
+        if(position >= inLine.size() || inLine[position] != '"' || !ParseJSONString(inLine, position, key)) {
+            outError = "Malformed request key";
+            return false;
+        }
+        SkipWhitespace(inLine, position);
+        if(position >= inLine.size() || inLine[position] != ':') {
+            outError = "Malformed request, expected :";
+            return false;
+        }
+        ++position;
+        SkipWhitespace(inLine, position);
+        if(position >= inLine.size()) {
+            outError = "Malformed request, missing value";
+            return false;
+        }
+
+        JSONValue value;
+        value.isString = inLine[position] == '"';
+        if(value.isString) {
+            if(!ParseJSONString(inLine, position, value.text)) {
+                outError = "Malformed request string value";
+                return false;
+            }
+        } else if(inLine[position] == '{' || inLine[position] == '[') {
+            outError = string("Unsupported value for ") + key + ", only strings, numbers, booleans and null are supported";
+            return false;
+        } else {
+            size_t valueEnd = inLine.find_first_of(",} \t\r\n", position);
+            if(valueEnd == string::npos)
+                valueEnd = inLine.size();
+            value.text = inLine.substr(position, valueEnd - position);
+            position = valueEnd;
+            // kept raw (and may be echoed back as is), so it better be valid JSON
+            if(!IsJSONLiteral(value.text)) {
+                outError = string("Malformed request value for ") + key;
+                return false;
+            }
+        }
+        outValues[key] = value;
+
+        SkipWhitespace(inLine, position);
+        if(position < inLine.size() && inLine[position] == ',') {
+            ++position;
+            continue;
+        }
+        if(position < inLine.size() && inLine[position] == '}')
+            return true;
+        outError = "Malformed request, expected , or }";
+        return false;
+    }
+
+    outError = "Malformed request, missing }";
+    return false;
+}
+
+static string EscapeJSONString(const string& inString) {
+    string result = "\"";
+    for(string::const_iterator it = inString.begin(); it != inString.end(); ++it) {
+        unsigned char c = (unsigned char)*it;
+        switch(c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if(c < 0x20) {
+                    static const char scHex[] = "0123456789abcdef";
+                    result += "\\u00";
+                    result += scHex[c >> 4];
+                    result += scHex[c & 0xF];
+                } else {
+                    result += (char)c;
+                }
+        }
+    }
+    return result + "\"";
+}
+
+// where responses go to. std output or a socket connection
+class IResponseWriter {
+    public:
+        virtual ~IResponseWriter() {}
+        virtual bool WriteLine(const string& inLine) = 0;
+};
+
+class StdOutputResponseWriter : public IResponseWriter {
+    public:
+        virtual bool WriteLine(const string& inLine) {
+            cout << inLine << "\n";
+            cout.flush();
+            return cout.good();
+        }
+};
+
+struct ServerRequest {
+    string id;
+    string path;
+    long startPage;
+    long endPage;
+    string mode;
+    int bidiFlag;
+    TextComposer::ESpacing spacing;
+    long timeoutMilliseconds;
+};
+
+static bool GetStringValue(const StringToJSONValueMap::iterator& inIt, string& outValue, string& outError) {
+    if(!inIt->second.isString) {
+        outError = inIt->first + " should be a string";
+        return false;
+    }
+    outValue = inIt->second.text;
+    return true;
+}
+
+// integers only, such as page indexes and milliseconds
+static bool GetIntegerValue(const StringToJSONValueMap::iterator& inIt, long& outValue, string& outError) {
+    const string& text = inIt->second.text;
+    if(inIt->second.isString || !IsJSONNumber(text) || text.find_first_of(".eE") != string::npos) {
+        outError = inIt->first + " should be an integer";
+        return false;
+    }
+    outValue = Long(text.c_str());
+    return true;
+}
+
+static bool ParseRequest(const string& inLine, ServerRequest& outRequest, string& outError) {
+    StringToJSONValueMap values;
+
+    outRequest.id = scNull;
+    outRequest.startPage = 0;
+    outRequest.endPage = -1;
+    outRequest.mode = scModeText;
+    outRequest.bidiFlag = -1;
+    outRequest.spacing = TextComposer::eSpacingBoth;
+    outRequest.timeoutMilliseconds = 0;
+
+    if(!ParseJSONObject(inLine, values, outError))
+        return false;
+
+    // id is echoed back as is, so string ids should be escaped again
+    StringToJSONValueMap::iterator it = values.find("id");
+    if(it != values.end())
+        outRequest.id = it->second.isString ? EscapeJSONString(it->second.text) : it->second.text;
+
+    it = values.find("path");
+    if(it == values.end() || it->second.text.empty()) {
+        outError = "Request is missing path";
+        return false;
+    }
+    if(!GetStringValue(it, outRequest.path, outError))
+        return false;
+
+    it = values.find("start");
+    if(it != values.end() && !GetIntegerValue(it, outRequest.startPage, outError))
+        return false;
+    it = values.find("end");
+    if(it != values.end() && !GetIntegerValue(it, outRequest.endPage, outError))
+        return false;
+
+    it = values.find("timeout");
+    if(it != values.end() && !GetIntegerValue(it, outRequest.timeoutMilliseconds, outError))
+        return false;
+
+    it = values.find("mode");
+    if(it != values.end()) {
+        if(!it->second.isString || (it->second.text != scModeText && it->second.text != scModeTables && it->second.text != scModeCombined)) {
+            outError = "mode should be either text, tables or combined";
+            return false;
+        }
+        outRequest.mode = it->second.text;
+    }
+
+    it = values.find("bidi");
+    if(it != values.end() && !(!it->second.isString && it->second.text == scNull)) {
+        if(!it->second.isString) {
+            outError = "bidi should be either LTR or RTL";
+            return false;
+        }
+        if(it->second.text == scBidiLTR)
+            outRequest.bidiFlag = 0;
+        else if(it->second.text == scBidiRTL)
+            outRequest.bidiFlag = 1;
+        else {
+            outError = "bidi should be either LTR or RTL";
+            return false;
+        }
+    }
+
+    it = values.find("spacing");
+    if(it != values.end()) {
+        if(!it->second.isString) {
+            outError = "spacing should be either BOTH, HOR, VER or NONE";
+            return false;
+        }
+        if(it->second.text == scSpacingBoth)
+            outRequest.spacing = TextComposer::eSpacingBoth;
+        else if(it->second.text == scSpacingHor)
+            outRequest.spacing = TextComposer::eSpacingHorizontal;
+        else if(it->second.text == scSpacingVer)
+            outRequest.spacing = TextComposer::eSpacingVertical;
+        else if(it->second.text == scSpacingNone)
+            outRequest.spacing = TextComposer::eSpacingNone;
+        else {
+            outError = "spacing should be either BOTH, HOR, VER or NONE";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// streams each page text back as soon as it's done
+class PageResponseWriter : public ITextExtractionPageHandler {
+    public:
+        PageResponseWriter(IResponseWriter* inWriter, const string& inId) {
+            writer = inWriter;
+            id = inId;
+        }
+
+        virtual bool OnPageTextPlacementsComplete(unsigned long inPageIndex, const ParsedTextPlacementList& inTextPlacements) {
+            return true;
+        }
+
+        virtual bool OnPageTextComplete(unsigned long inPageIndex, const std::string& inText) {
+            // stop extracting if the client is gone
+            return writer->WriteLine(string("{\"id\":") + id + ",\"page\":" + ULong(inPageIndex).ToString() + ",\"text\":" + EscapeJSONString(inText) + "}");
+        }
+
+    private:
+        IResponseWriter* writer;
+        string id;
+};
+
+// state kept between requests. that's the last document, kept parsed for as long as it's requested again (and not modified)
+class ExtractionServer {
+    public:
+        ExtractionServer() {}
+
+        // returns false if the response could not be written
+        bool HandleRequestLine(const string& inLine, IResponseWriter* inWriter) {
+            ServerRequest request;
+            string error;
+
+            if(inLine.find_first_not_of(" \t\r\n") == string::npos)
+                return true;
+
+            if(!ParseRequest(inLine, request, error))
+                return WriteStatus(inWriter, request.id, error);
+
+            // time budget includes opening the document, though with a warm session that's mostly free
+            CancellationToken cancellationToken;
+            if(request.timeoutMilliseconds > 0)
+                cancellationToken.SetTimeBudget((unsigned long)request.timeoutMilliseconds);
+
+            if(!OpenSession(request.path, error))
+                return WriteStatus(inWriter, request.id, error);
+
+            if(request.mode == scModeText) {
+                PageResponseWriter pageWriter(inWriter, request.id);
+                TextExtraction textExtraction;
+                textExtraction.SetCancellationToken(&cancellationToken);
+                textExtraction.SetPageHandler(&pageWriter, request.bidiFlag, request.spacing);
+                if(textExtraction.ExtractText(session, request.startPage, request.endPage) != eSuccess)
+                    error = textExtraction.LatestError.description;
+            } else {
+                TableExtraction tableExtraction;
+                tableExtraction.SetCancellationToken(&cancellationToken);
+                EStatusCode status = tableExtraction.ExtractTables(session, request.startPage, request.endPage);
+                if(status != eSuccess)
+                    error = tableExtraction.LatestError.description;
+                // timed out extraction still has the pages completed till then
+                if(status == eSuccess || tableExtraction.LatestError.code == eErrorTimeout || tableExtraction.LatestError.code == eErrorCancelled) {
+                    string response = string("{\"id\":") + request.id;
+                    if(request.mode == scModeCombined)
+                        response += string(",\"text\":") + EscapeJSONString(tableExtraction.GetResultsAsText(request.bidiFlag, request.spacing));
+                    response += string(",\"tables\":") + EscapeJSONString(tableExtraction.GetAllAsCSVText(request.bidiFlag, request.spacing)) + "}";
+                    if(!inWriter->WriteLine(response))
+                        return false;
+                }
+            }
+
+            return WriteStatus(inWriter, request.id, error);
+        }
+
+    private:
+        DocumentSession session;
+        string sessionPath;
+        filesystem::file_time_type sessionFileTime;
+
+        bool OpenSession(const string& inPath, string& outError) {
+            error_code ec;
+            filesystem::file_time_type fileTime = filesystem::last_write_time(inPath, ec);
+
+            if(session.IsOpen() && sessionPath == inPath && !ec && fileTime == sessionFileTime)
+                return true;
+
+            sessionPath = inPath;
+            sessionFileTime = fileTime;
+            if(session.Open(inPath) != eSuccess) {
+                outError = session.LatestError.description;
+                return false;
+            }
+            return true;
+        }
+
+        bool WriteStatus(IResponseWriter* inWriter, const string& inId, const string& inError) {
+            if(inError.empty())
+                return inWriter->WriteLine(string("{\"id\":") + inId + ",\"status\":\"ok\"}");
+            else
+                return inWriter->WriteLine(string("{\"id\":") + inId + ",\"status\":\"error\",\"error\":" + EscapeJSONString(inError) + "}");
+        }
+};
+
+int RunExtractionServer() {
+    ExtractionServer server;
+    StdOutputResponseWriter writer;
+    string line;
+
+    while(getline(cin, line)) {
+        if(!server.HandleRequestLine(line, &writer))
+            break;
+    }
+
+    return 0;
+}
+
+#ifndef _WIN32
+
+class SocketResponseWriter : public IResponseWriter {
+    public:
+        SocketResponseWriter(int inSocket) {
+            socket = inSocket;
+        }
+
+        virtual bool WriteLine(const string& inLine) {
+            string data = inLine + "\n";
+            size_t written = 0;
+            while(written < data.size()) {
+                ssize_t result = write(socket, data.c_str() + written, data.size() - written);
+                if(result <= 0)
+                    return false;
+                written += (size_t)result;
+            }
+            return true;
+        }
+
+    private:
+        int socket;
+};
+
+// connections served at once, each holding a thread and a parsed document. more clients wait in the listen backlog
+static const size_t scMaxConnections = 16;
+// pause before accepting again after failing for lack of resources (e.g. out of file descriptors)
+static const chrono::milliseconds scAcceptRetryDelay(100);
+
+static mutex connectionsMutex;
+static condition_variable connectionEnded;
+static size_t connectionsCount = 0;
+
+static void WaitForConnectionSlot() {
+    unique_lock<mutex> lock(connectionsMutex);
+    connectionEnded.wait(lock, [] { return connectionsCount < scMaxConnections; });
+    ++connectionsCount;
+}
+
+static void ReleaseConnectionSlot() {
+    {
+        lock_guard<mutex> lock(connectionsMutex);
+        --connectionsCount;
+    }
+    connectionEnded.notify_one();
+}
+
+// serves a connection till it closes, with its own server (and so its own warm document)
+static void ServeConnectionRequests(int inConnection) {
+    ExtractionServer server;
+    SocketResponseWriter writer(inConnection);
+    string pending;
+    char buffer[4096];
+
+    while(true) {
+        ssize_t readCount = read(inConnection, buffer, sizeof(buffer));
+        if(readCount <= 0)
+            break;
+        pending.append(buffer, (size_t)readCount);
+
+        size_t lineEnd;
+        while((lineEnd = pending.find('\n')) != string::npos) {
+            string line = pending.substr(0, lineEnd);
+            pending.erase(0, lineEnd + 1);
+            if(!server.HandleRequestLine(line, &writer)) {
+                close(inConnection);
+                return;
+            }
+        }
+    }
+
+    // last request may not end with a newline
+    if(!pending.empty())
+        server.HandleRequestLine(pending, &writer);
+    close(inConnection);
+}
+
+static void ServeConnection(int inConnection) {
+    ServeConnectionRequests(inConnection);
+    ReleaseConnectionSlot();
+}
+
+int RunExtractionServer(const std::string& inSocketPath) {
+    struct sockaddr_un address;
+    if(inSocketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Error: Socket path is too long " << inSocketPath.c_str() << endl;
+        return 1;
+    }
+
+    // a client going away while writing to it should not bring the server down
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0) {
+        cerr << "Error: Cannot create socket" << endl;
+        return 1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, inSocketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(inSocketPath.c_str());
+
+    if(bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        cerr << "Error: Cannot listen on socket " << inSocketPath.c_str() << endl;
+        close(listener);
+        return 1;
+    }
+
+    cerr << "Serving extraction requests on " << inSocketPath.c_str() << endl;
+
+    // each connection is served on its own thread, so that a client that is slow (or idle) doesn't hold up the others
+    while(true) {
+        WaitForConnectionSlot();
+
+        int connection = accept(listener, NULL, NULL);
+        if(connection < 0) {
+            int error = errno;
+            ReleaseConnectionSlot();
+            if(error == EINTR || error == ECONNABORTED)
+                continue;
+            if(error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM) {
+                // out of resources for now. give connections a chance to end rather than spinning
+                this_thread::sleep_for(scAcceptRetryDelay);
+                continue;
+            }
+            cerr << "Error: Failed to accept connections on socket " << inSocketPath.c_str() << ", " << strerror(error) << endl;
+            close(listener);
+            return 1;
+        }
+
+        try {
+            thread(ServeConnection, connection).detach();
+        } catch(const system_error&) {
+            // no thread to serve it on
+            close(connection);
+            ReleaseConnectionSlot();
+            this_thread::sleep_for(scAcceptRetryDelay);
+        }
+    }
+
+    return 0;
+}
+
+#else
+
+int RunExtractionServer(const std::string& inSocketPath) {
+    cerr << "Error: Serving on a unix socket is not supported on this platform, serve on std input instead" << endl;
+    return 1;
+}
+
+#endif
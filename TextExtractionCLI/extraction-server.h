@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Extraction server keeps the process (and its static state) resident and serves extraction requests.
+ * Requests are JSON lines such as:
+ * {"id": 1, "path": "/path/to/file.pdf", "start": 0, "end": -1, "mode": "text", "spacing": "BOTH", "bidi": "LTR"}
+ * where only "path" is required. mode is one of text (default), tables or combined. add "timeout" (milliseconds) to limit
+ * the request time, in which case it ends with an error status after returning the pages completed in time.
+ * Results are streamed back as JSON lines - text mode writes a line per page as soon as it's done,
+ * and each request ends with a status line, {"id": 1, "status": "ok"} or {"id": 1, "status": "error", "error": "..."}.
+ * The last opened document is kept parsed, so successive requests on the same file don't parse it again. with a unix socket
+ * each connection is served concurrently on its own thread, and keeps its own last document. Up to 16 connections are
+ * served at once, and further clients wait to be accepted till one of them ends.
+ * Values are validated - path, mode, bidi and spacing are strings, start, end and timeout are integers, and a malformed
+ * request ends with an error status.
+ **/
+
+// serve requests from std input, writing results to std output. returns when input ends.
+int RunExtractionServer();
+// serve requests from connections to a unix domain socket at the socket path. doesn't return unless failing to listen (or accept).
+int RunExtractionServer(const std::string& inSocketPath);